@@ -70,6 +70,55 @@ extern "C" {
     DLLINTERFACE SDL_Surface *rotozoomSurfaceXY
     (SDL_Surface * src, double angle, double zoomx, double zoomy, int smooth);
 
+/* 
+ 
+ rotozoomSurfaceXYInto()
+
+ Rotates and zoomes a 32bit 'src' surface into the existing 32bit 'dst' surface,
+ reusing its pixel buffer instead of allocating a new one. Only the top-left
+ '*dstwidth' x '*dstheight' area of 'dst' is written. Returns 0 on success,
+ -1 if 'src' or 'dst' are not usable (not 32bit or different pixel layout) and
+ -2 if 'dst' is NULL or too small; in that case '*dstwidth' and '*dstheight'
+ still hold the required size so the caller can grow the buffer and retry.
+
+*/
+
+    DLLINTERFACE int rotozoomSurfaceXYInto
+    (SDL_Surface * src, SDL_Surface * dst, double angle, double zoomx, double zoomy, int smooth,
+     int *dstwidth, int *dstheight);
+
+/* 
+ 
+ rotozoomSurfaceXYBlit()
+
+ Rotates and zoomes a 32bit 'src' surface straight into the 32bit 'dst' surface
+ in a single pass, centered at 'x','y', without an intermediate surface. The
+ mapping is the same as rotozoomSurfaceXY() without smoothing followed by a
+ centered SDL_BlitSurface(). If 'flags' contains SDL_SRCCOLORKEY, source pixels
+ equal to 'colorkey' are skipped; 'alpha' is the per-surface alpha (255 = opaque).
+ 'dstrect' (optional) receives the clipped area that was written.
+ Returns 0 on success and -1 if the surfaces cannot be composited directly
+ (not 32bit, different RGB layout or per-pixel alpha in 'src').
+
+*/
+
+    DLLINTERFACE int rotozoomSurfaceXYBlit
+    (SDL_Surface * src, SDL_Surface * dst, int x, int y, double angle, double zoomx, double zoomy,
+     Uint32 flags, Uint32 colorkey, Uint8 alpha, SDL_Rect * dstrect);
+
+/* 
+ 
+ rotozoomUseSIMD()
+
+ Enables (default) or disables the SSE2/NEON bilinear kernels used when
+ smoothing is on. The SIMD kernels are only used if the CPU supports them and
+ produce the same output as the scalar code; disabling them is meant for
+ comparing both paths.
+
+*/
+
+    DLLINTERFACE void rotozoomUseSIMD(int enable);
+
 /* Returns the size of the target surface for a rotozoomSurface() call */
 
     DLLINTERFACE void rotozoomSurfaceSize(int width, int height, double angle, double zoom, int *dstwidth,
@@ -0,0 +1,132 @@
+#ifndef SHEETREGISTRY_H
+#define SHEETREGISTRY_H
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+/**
+ * @file SheetRegistry.h
+ * @brief Registro de hojas de sprites compartidas con conteo de referencias.
+ */
+
+struct SheetEntry;
+
+/**
+ * @class SheetHandle
+ * @brief Referencia con propiedad a una superficie, solo movible.
+ *
+ * Mientras exista al menos un handle la superficie sigue viva; el último en
+ * destruirse la libera. No se puede copiar: para compartir la superficie hay
+ * que pedirlo explícitamente con `share()`.
+ */
+class SheetHandle {
+public:
+    /** @brief Crea un handle vacío. */
+    SheetHandle();
+
+    /** @brief Suelta la referencia. */
+    ~SheetHandle();
+
+    SheetHandle(SheetHandle &&other);
+    SheetHandle& operator=(SheetHandle &&other);
+    SheetHandle(const SheetHandle &) = delete;
+    SheetHandle& operator=(const SheetHandle &) = delete;
+
+    /**
+     * @brief Toma posesión de una superficie que no está en el registro.
+     * @param surface Superficie; se libera con el último handle.
+     */
+    static SheetHandle adopt(SDL_Surface *surface);
+
+    /** @brief Devuelve otra referencia a la misma superficie. */
+    SheetHandle share() const;
+
+    /**
+     * @brief Garantiza que este handle es el único dueño de la superficie.
+     *
+     * Si la superficie está compartida se hace una copia propia (copia al
+     * escribir). Hay que llamarlo antes de modificar píxeles o color clave.
+     * @return false si no se pudo copiar.
+     */
+    bool detach();
+
+    /** @brief Suelta la referencia y deja el handle vacío. */
+    void reset();
+
+    /** @brief Superficie referenciada o NULL. */
+    SDL_Surface* get() const;
+
+    /** @brief Indica si el handle referencia una superficie. */
+    bool valid() const;
+
+    /** @brief Indica si hay otros handles a la misma superficie. */
+    bool shared() const;
+
+    /** @brief Número de handles que referencian la superficie. */
+    int refs() const;
+
+private:
+    friend class SheetRegistry;
+    explicit SheetHandle(SheetEntry *entry);
+
+    SheetEntry *entry;          ///< Entrada compartida o NULL.
+};
+
+/**
+ * @class SheetRegistry
+ * @brief Registro de hojas cargadas (flyweight).
+ *
+ * Cargar el mismo archivo o el mismo buffer varias veces devuelve la misma
+ * superficie ya convertida al formato de pantalla; 500 enemigos de una misma
+ * hoja comparten una sola superficie. La entrada se elimina cuando se suelta
+ * el último handle.
+ */
+class SheetRegistry {
+public:
+    /**
+     * @brief Carga (o reutiliza) una hoja desde archivo.
+     * @param file Ruta de la imagen.
+     * @return Handle vacío si la carga falla.
+     */
+    static SheetHandle loadFile(const char *file);
+
+    /**
+     * @brief Carga (o reutiliza) una hoja desde memoria.
+     *
+     * Se identifica por dirección y tamaño del buffer, pensado para recursos
+     * embebidos que no cambian.
+     * @param buffer Datos de la imagen.
+     * @param len Tamaño en bytes.
+     * @return Handle vacío si la carga falla.
+     */
+    static SheetHandle loadMemory(const u8 *buffer, int len);
+
+    /**
+     * @brief Carga (o reutiliza) una hoja en modo indexado de 8 bits.
+     *
+     * Las imágenes de 8 bits se guardan tal cual; las demás se convierten con
+     * `convertIndexed()`. Ocupa la cuarta parte que la versión de 32 bits.
+     * @param file Ruta de la imagen.
+     * @return Handle vacío si la carga falla o la imagen tiene más de 256 colores.
+     */
+    static SheetHandle loadFileIndexed(const char *file);
+
+    /**
+     * @brief Igual que `loadFileIndexed` pero desde memoria.
+     */
+    static SheetHandle loadMemoryIndexed(const u8 *buffer, int len);
+
+    /**
+     * @brief Convierte una superficie a 8 bits con paleta exacta.
+     *
+     * El color clave se conserva como índice de la paleta.
+     * @param src Superficie de origen (no se modifica).
+     * @return Nueva superficie o NULL si hay más de 256 colores distintos.
+     */
+    static SDL_Surface* convertIndexed(SDL_Surface *src);
+
+    /** @brief Número de hojas registradas actualmente. */
+    static int count();
+};
+
+#endif // SHEETREGISTRY_H
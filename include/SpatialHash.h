@@ -0,0 +1,143 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <vector>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <Sprite.h>
+
+/**
+ * @file SpatialHash.h
+ * @brief Fase amplia (broadphase) de colisiones con una rejilla uniforme dispersa.
+ */
+
+/**
+ * @struct SpatialPair
+ * @brief Par de entidades cuyos rectángulos se tocan o se solapan.
+ */
+struct SpatialPair {
+    int a;                  ///< Identificador menor del par.
+    int b;                  ///< Identificador mayor del par.
+};
+
+/**
+ * @class SpatialHash
+ * @brief Rejilla uniforme indexada por hash para encontrar pares candidatos.
+ *
+ * Cada entidad ocupa las celdas que cubre su rectángulo (posición más
+ * `getWidth()`/`getHeight()` del sprite). Solo se comparan las entidades que
+ * comparten celda, así que el coste crece con el número de vecinos y no con
+ * el cuadrado del total. Los pares devueltos se pasan después a
+ * `Sprite::rectCollide` o `Sprite::pixelCollide`.
+ *
+ * El tamaño de celda ideal es del orden del sprite típico (por ejemplo 32 o
+ * 64 píxeles).
+ */
+class SpatialHash {
+public:
+    /**
+     * @brief Constructor.
+     * @param cellSize Lado de cada celda en píxeles.
+     * @param buckets Número de cubetas de la tabla hash (se redondea a
+     *                potencia de 2).
+     */
+    SpatialHash(int cellSize = 64, int buckets = 4096);
+
+    /**
+     * @brief Inserta un sprite en una posición.
+     * @param sprite Sprite; se usan su ancho y alto de frame.
+     * @param x Posición X.
+     * @param y Posición Y.
+     * @param user Dato libre asociado a la entidad.
+     * @return Identificador de la entidad.
+     */
+    int insert(Sprite &sprite, int x, int y, void *user = NULL);
+
+    /**
+     * @brief Inserta un rectángulo arbitrario.
+     * @return Identificador de la entidad.
+     */
+    int insertRect(int x, int y, int w, int h, void *user = NULL);
+
+    /**
+     * @brief Mueve una entidad conservando su tamaño.
+     *
+     * Si la entidad sigue en las mismas celdas solo se actualiza su posición.
+     */
+    void move(int id, int x, int y);
+
+    /** @brief Mueve y cambia el tamaño de una entidad. */
+    void moveRect(int id, int x, int y, int w, int h);
+
+    /** @brief Elimina una entidad; su identificador podrá reutilizarse. */
+    void remove(int id);
+
+    /** @brief Elimina todas las entidades. */
+    void clear();
+
+    /**
+     * @brief Obtiene todos los pares de entidades cuyos rectángulos se tocan.
+     *
+     * Cada par aparece una sola vez. Igual que `rectCollide`, los rectángulos
+     * que solo se tocan en el borde cuentan como candidatos.
+     * @param out Vector donde se escriben los pares (se vacía antes).
+     * @return Número de pares.
+     */
+    int findPairs(std::vector<SpatialPair> &out);
+
+    /**
+     * @brief Obtiene las entidades que tocan un rectángulo.
+     * @param out Vector donde se escriben los identificadores (se vacía antes).
+     * @return Número de entidades.
+     */
+    int query(int x, int y, int w, int h, std::vector<int> &out);
+
+    /** @brief Sprite asociado a una entidad (NULL si se insertó un rectángulo). */
+    Sprite* getSprite(int id);
+
+    /** @brief Dato libre asociado a una entidad. */
+    void* getUser(int id);
+
+    /** @brief Posición X de una entidad. */
+    int getX(int id);
+
+    /** @brief Posición Y de una entidad. */
+    int getY(int id);
+
+    /** @brief Número de entidades activas. */
+    int size();
+
+private:
+    /** @brief Entidad registrada. */
+    struct Entity {
+        int x, y, w, h;             ///< Rectángulo.
+        int cx0, cy0, cx1, cy1;     ///< Celdas cubiertas (inclusive).
+        Sprite *sprite;             ///< Sprite asociado o NULL.
+        void *user;                 ///< Dato libre.
+        bool used;                  ///< Ranura ocupada.
+    };
+
+    /** @brief Entrada de una cubeta: entidad y celda exacta. */
+    struct CellItem {
+        int id;
+        int cx, cy;
+    };
+
+    int cellOf(int v) const;
+    int bucketOf(int cx, int cy) const;
+    void link(int id);
+    void unlink(int id);
+    bool valid(int id) const;
+    static bool touches(const Entity &a, const Entity &b);
+
+    int cellSize;                               ///< Lado de celda en píxeles.
+    int bucketMask;                             ///< Cubetas - 1.
+    int count;                                  ///< Entidades activas.
+    std::vector<Entity> entities;               ///< Entidades por identificador.
+    std::vector<int> freeIds;                   ///< Identificadores libres.
+    std::vector< std::vector<CellItem> > buckets; ///< Tabla hash de celdas.
+    std::vector<int> stamp;                     ///< Marcas para `query`.
+    int stampValue;                             ///< Marca actual de `query`.
+};
+
+#endif // SPATIALHASH_H
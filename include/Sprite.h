@@ -3,9 +3,11 @@
 
 #include <cstdlib>
 #include <string>
+#include <vector>
 #include <math.h>
 #include <SDL/SDL.h>
 #include <types.h>
+#include <SheetRegistry.h>
 
 /**
  * @file Sprite.h
@@ -20,6 +22,18 @@
 
 class SpriteEffects;
 
+/**
+ * @struct SpriteFrame
+ * @brief Vista ligera de un frame: la hoja completa más el rectángulo del frame.
+ *
+ * No reserva memoria ni copia píxeles; sirve directamente como `srcrect` de
+ * `SDL_BlitSurface`. Es válida mientras el sprite no cambie de superficie.
+ */
+struct SpriteFrame {
+    SDL_Surface* surface;      ///< Hoja de sprites (no se debe liberar).
+    SDL_Rect rect;             ///< Rectángulo del frame dentro de la hoja.
+};
+
 /**
  * @class Sprite
  * @brief Representa un sprite animado con soporte para múltiples frames y efectos gráficos.
@@ -39,14 +53,40 @@ public:
     /** @brief Destructor. Libera recursos asociados al sprite. */
     virtual ~Sprite();
 
+    /**
+     * @brief Los sprites no se copian, solo se mueven.
+     *
+     * Varios sprites pueden compartir la misma hoja a través de
+     * `SheetRegistry`; una copia accidental ya no duplica ni libera la hoja.
+     */
+    Sprite(const Sprite &) = delete;
+    Sprite& operator=(const Sprite &) = delete;
+
+    /** @brief Mueve el sprite; el origen queda vacío. */
+    Sprite(Sprite &&other);
+
+    /** @brief Mueve el sprite; el origen queda vacío. */
+    Sprite& operator=(Sprite &&other);
+
     /**
      * @brief Constructor que carga un sprite desde un archivo.
+     *
+     * Si el archivo ya estaba cargado se reutiliza la misma hoja.
      * @param file Ruta del archivo de imagen.
      * @param frames Número de frames que contiene.
      * @param speed Velocidad de animación (ms por frame).
      */
     Sprite(const char *file, int frames, int speed);
-    
+
+    /**
+     * @brief Constructor que carga un sprite desde un buffer en memoria.
+     *
+     * Si el mismo buffer ya estaba cargado se reutiliza la misma hoja.
+     * @param buffer Datos de la imagen.
+     * @param len Tamaño del buffer en bytes.
+     * @param frames Número de frames que contiene.
+     * @param speed Velocidad de animación (ms por frame).
+     */
     Sprite(u8* buffer, int len, int frames, int speed);
 
     /**
@@ -65,12 +105,87 @@ public:
      */
     void load(const char *file, int frames, int speed);
 
+    /**
+     * @brief Carga un sprite en modo indexado (8 bits + paleta de 256 colores).
+     *
+     * Ocupa la cuarta parte que una hoja de 32 bits y se dibuja expandiendo
+     * la paleta directamente sobre el destino. Falla si la imagen tiene más de
+     * 256 colores distintos.
+     * @param file Ruta del archivo de imagen.
+     * @param frames Número de frames.
+     * @param speed Velocidad de animación (ms por frame).
+     */
+    void loadIndexed(const char *file, int frames, int speed);
+
+    /** @brief Igual que `loadIndexed(const char*, ...)` pero desde memoria. */
+    void loadIndexed(u8* buffer, int len, int frames, int speed);
+
+    /** @brief Indica si el sprite usa una hoja indexada de 8 bits. */
+    bool isIndexed();
+
+    /**
+     * @brief Cambia un color de la paleta propia del sprite.
+     *
+     * Solo afecta a este sprite: la hoja no se toca y el coste no depende del
+     * número de píxeles.
+     */
+    Sprite* setPaletteColor(int index, Uint8 r, Uint8 g, Uint8 b);
+
+    /** @brief Reemplaza `count` colores de la paleta a partir de `first`. */
+    Sprite* setPalette(const SDL_Color *colors, int first, int count);
+
+    /** @brief Vuelve a la paleta original de la hoja. */
+    Sprite* resetPalette();
+
+    /**
+     * @brief Paleta convertida al formato `fmt` con el tinte aplicado.
+     *
+     * Se reconstruye solo cuando cambian la paleta, el tinte o el formato.
+     * @return Tabla de 256 entradas o NULL si el sprite no es indexado.
+     */
+    const Uint32* getPaletteLUT(SDL_PixelFormat *fmt);
+
     /**
      * @brief Obtiene la superficie del frame actual.
+     *
+     * Crea una superficie nueva en cada llamada que el llamador debe liberar.
+     * Para uso por frame conviene `getFrameView()` o `getFrameSurface()`.
      * @return Puntero a la superficie SDL correspondiente al frame actual.
      */
     SDL_Surface* getCurrentFrame();
 
+    /**
+     * @brief Obtiene una vista del frame actual sin reservar memoria.
+     * @return Hoja de sprites y rectángulo del frame actual.
+     */
+    SpriteFrame getFrameView();
+
+    /**
+     * @brief Obtiene una vista de un frame sin reservar memoria.
+     * @param frame Índice del frame (0 .. getMaxFrames()-1).
+     * @return Hoja de sprites y rectángulo del frame; rectángulo vacío si el
+     *         índice no es válido.
+     */
+    SpriteFrame getFrameView(int frame);
+
+    /**
+     * @brief Crea una superficie independiente por cada frame.
+     *
+     * Pensado para llamarse una vez tras la carga, para el código que necesita
+     * un `SDL_Surface` propio por frame. Las superficies se regeneran solas si
+     * un efecto cambia la hoja, y se liberan con el sprite.
+     * @return Puntero al propio sprite.
+     */
+    Sprite* cacheFrames();
+
+    /**
+     * @brief Obtiene la superficie independiente de un frame.
+     * @param frame Índice del frame.
+     * @return Superficie del frame (propiedad del sprite, no liberar) o NULL
+     *         si no se llamó a `cacheFrames()` o el índice no es válido.
+     */
+    SDL_Surface* getFrameSurface(int frame);
+
     /**
      * @brief Dibuja el sprite en un buffer destino.
      * @param buffer Superficie destino.
@@ -80,6 +195,24 @@ public:
      */
     Sprite* draw(SDL_Surface* buffer, int x, int y);
 
+    /**
+     * @brief Graba el frame actual en el renderizador diferido o, si no se
+     *        está grabando, en la cola de `render_queue.h`.
+     *
+     * `draw()` lo usa cuando su destino es `deferred_target()` o
+     * `render_queue_target()`. Se graba con la opacidad y el tinte actuales;
+     * los sprites indexados se expanden con su paleta. En la cola va a la
+     * capa de `render_queue_layer()`; los sprites con opacidad, tinte o
+     * paleta se graban como orden propia y no se agrupan con su hoja.
+     *
+     * @note Si la hoja usa RLE, lo pierde hasta `deferred_end()` (ver
+     *       `deferred_blit`): dibujarla también sin diferir en el mismo frame
+     *       la obliga a codificarse de nuevo.
+     * @param x Posición X en pantalla.
+     * @param y Posición Y en pantalla.
+     */
+    void queue(int x, int y);
+
     /**
      * @brief Define un color como transparente.
      * @param color Color en formato Uint32.
@@ -108,7 +241,13 @@ public:
     /** @brief Reinicia la animación desde el primer frame. */
     Sprite* restart();
 
-    /** @brief Avanza la animación al siguiente frame según la velocidad configurada. */
+    /**
+     * @brief Avanza la animación en este frame si está en marcha.
+     *
+     * Hay que llamarla en cada frame en que el sprite deba animarse; si no
+     * se llama, se queda en su frame. El avance lo hace `anim_update()` en
+     * `Render()`, con una sola lectura del reloj para todos los sprites.
+     */
     Sprite* animate();
 
     /**
@@ -135,6 +274,9 @@ public:
     /** @brief Obtiene el número máximo de frames. */
     int getMaxFrames();
 
+    /** @brief Obtiene el handle de la animación (ver `anim.h`). */
+    int getAnimation();
+
     /** @brief Obtiene el ancho de un frame. */
     int getWidth();
 
@@ -153,16 +295,24 @@ public:
     /** @brief Obtiene el alto total de la superficie del sprite. */
     int getSpriteHeight();
 
-    /** @brief Compara si dos sprites son iguales. */
-    bool equals(Sprite compare);
+    /** @brief Indica si dos sprites usan la misma hoja. */
+    bool equals(Sprite &compare);
 
     /** @brief Obtiene la superficie completa del sprite. */
     SDL_Surface* getSurface();
 
-    /** @brief Asigna una superficie SDL como sprite. */
+    /**
+     * @brief Asigna una superficie SDL como sprite.
+     *
+     * El sprite toma posesión de la superficie y suelta la hoja anterior.
+     */
     Sprite* setSurface(SDL_Surface* surface);
 
-    /** @brief Libera la memoria asociada al sprite. */
+    /**
+     * @brief Libera la memoria asociada al sprite.
+     *
+     * La hoja solo se libera si ningún otro sprite la usa.
+     */
     Sprite* destroy();
 
     /** @brief Verifica si un píxel específico es transparente. */
@@ -214,6 +364,21 @@ public:
     /** @brief Detecta colisión por píxeles entre este sprite y otro. */
     bool pixelCollide(int x1, int y1, Sprite &spriteB, int x2, int y2);
 
+    /**
+     * @brief Obtiene la máscara de colisión de un frame.
+     *
+     * Un bit por píxel (1 = sólido), fila a fila, con `getCollisionMaskPitch()`
+     * palabras de 64 bits por fila; el bit 0 de cada palabra es el píxel más a
+     * la izquierda. Se construye la primera vez que se necesita y se rehace
+     * sola cuando cambian la hoja, el color key o algún píxel.
+     * @param frame Índice del frame.
+     * @return Puntero a la primera fila o NULL si el índice no es válido.
+     */
+    const Uint64* getCollisionMask(int frame);
+
+    /** @brief Número de palabras de 64 bits por fila de la máscara de colisión. */
+    int getCollisionMaskPitch();
+
     /** @brief Rota el sprite 90 grados. */
     Sprite* rotate90();
 
@@ -229,9 +394,31 @@ public:
     /** @brief Voltea verticalmente el sprite. */
     Sprite* flipVertical();
 
-    /** @brief Aplica un efecto de desvanecimiento. */
+    /**
+     * @brief Aplica un efecto de desvanecimiento.
+     *
+     * Solo cambia la opacidad con la que se dibuja este sprite; la hoja no se
+     * modifica, así que cada sprite puede desvanecerse por separado.
+     * @param fade Opacidad en porcentaje (100 = opaco, 0 = invisible).
+     */
     Sprite* fade(float fade);
 
+    /** @brief Cambia la opacidad de dibujo (255 = opaco). No modifica la hoja. */
+    Sprite* setAlpha(Uint8 alpha);
+
+    /** @brief Obtiene la opacidad de dibujo. */
+    Uint8 getAlpha();
+
+    /**
+     * @brief Multiplica el color del sprite al dibujarlo.
+     *
+     * (255, 255, 255) desactiva el tinte. Útil para destellos de daño.
+     */
+    Sprite* setTint(Uint8 r, Uint8 g, Uint8 b);
+
+    /** @brief Tinte actual como píxel en el formato de la hoja. */
+    Uint32 getTint();
+
     /** @brief Invierte el orden de los frames en la animación. */
     Sprite* reverseAnimation();
 
@@ -248,17 +435,50 @@ public:
     Sprite* stretch(float x, float y);
 
 private:
+    /** @brief Recalcula los rectángulos de todos los frames. */
+    void buildFrameRects();
+
+    /** @brief Regenera las superficies por frame si la caché está activa. */
+    void buildFrameCache();
+
+    /** @brief Libera las superficies por frame. */
+    void freeFrameCache();
+
+    /** @brief Construye las máscaras de colisión de todos los frames. */
+    void buildCollisionMask();
+
+    /** @brief Copia la hoja si está compartida, antes de modificarla. */
+    bool makeUnique();
+
+    /** @brief Adopta una hoja cargada y prepara frames y animación. */
+    void useSheet(SheetHandle &&handle, int frames, int speed);
+
+    /** @brief Copia la paleta de la hoja si es indexada. */
+    void syncPalette();
+
+    /** @brief Crea o reconfigura la animación asociada. */
+    void initAnimation(int frames, int speed, bool running);
+
     bool loaded;               ///< Indica si el sprite está cargado.
-    bool run;                  ///< Indica si la animación está activa.
-    Uint32 speed;               ///< Velocidad de animación (ms por frame).
     Uint32 width;               ///< Ancho de un frame.
     Uint32 height;              ///< Alto de un frame.
-    Uint32 index;               ///< Frame actual.
-    Uint32 indexIterator;       ///< Iterador interno de frames.
-    bool loopToBeginning;       ///< Control de bucle de animación.
     Uint32 maxFrames;           ///< Número máximo de frames.
-    Uint32 lastAnimated;        ///< Marca de tiempo de la última animación.
-    SDL_Surface* sprite;        ///< Superficie SDL del sprite.
+    int anim;                   ///< Handle de la animación en el sistema `anim`.
+    SheetHandle sheet;          ///< Propiedad (compartida) de la hoja.
+    SDL_Surface* sprite;        ///< Superficie SDL del sprite (`sheet.get()`).
+    std::vector<SDL_Rect> frameRects;       ///< Rectángulo de cada frame en la hoja.
+    std::vector<SDL_Surface*> frameCache;   ///< Superficie propia de cada frame.
+    bool frameCacheEnabled;     ///< Indica si se pidió `cacheFrames()`.
+    std::vector<Uint64> collisionMask;      ///< Máscaras de todos los frames, 1 bit por píxel.
+    int collisionMaskPitch;     ///< Palabras de 64 bits por fila de máscara.
+    bool collisionMaskDirty;    ///< La máscara debe reconstruirse.
+    Uint8 drawAlpha;            ///< Opacidad de dibujo.
+    Uint8 tintR, tintG, tintB;  ///< Tinte de dibujo.
+    std::vector<SDL_Color> palette;     ///< Paleta propia en modo indexado.
+    std::vector<Uint32> paletteLUT;     ///< Paleta en el formato del destino.
+    SDL_PixelFormat* lutFormat; ///< Formato de `paletteLUT`.
+    Uint32 lutTint;             ///< Tinte aplicado a `paletteLUT`.
+    bool lutDirty;              ///< `paletteLUT` debe reconstruirse.
 };
 
 /**
@@ -278,6 +498,66 @@ public:
     static void rotate(Sprite &sprite, int dir);
     static void flip(Sprite &sprite, int dir);
     static void fade(Sprite &sprite, float fade);
+
+    /**
+     * @brief Dibuja el frame actual con la opacidad y el tinte del sprite.
+     *
+     * Con hojas y destino de 32 bits del mismo formato usa núcleos SSE2/NEON
+     * de 4 píxeles; en otro caso mezcla píxel a píxel. Si la hoja usa RLE
+     * lo pierde la primera vez, para no decodificarla en cada dibujo.
+     */
+    static void drawBlended(Sprite &sprite, SDL_Surface *dst, int x, int y);
+
+    /**
+     * @brief Como `drawBlended` con una zona de la hoja y el estado dados,
+     *        sin consultar el sprite.
+     *
+     * La cola de `render_queue.h` la usa con el estado tomado al grabar.
+     * @param rect Zona de `src`.
+     * @param alpha Opacidad de 0 a 255.
+     * @param tint Tinte en el formato de `src`.
+     * @param useKey Saltar los píxeles iguales a `key`.
+     */
+    static void drawBlendedFrame(SDL_Surface *src, const SDL_Rect &rect, Uint8 alpha, Uint32 tint,
+                                 bool useKey, Uint32 key, SDL_Surface *dst, int x, int y);
+
+    /**
+     * @brief Dibuja el frame actual de un sprite indexado.
+     *
+     * Expande cada índice con la paleta del sprite directamente sobre
+     * destinos de 16 o 32 bits; el tinte va ya aplicado en la tabla.
+     */
+    static void drawIndexed(Sprite &sprite, SDL_Surface *dst, int x, int y);
+
+    /**
+     * @brief Expande una zona de una hoja de 8 bits sobre un destino de 16 o
+     *        32 bits, sin consultar el estado del sprite.
+     *
+     * El renderizador diferido la usa con el frame, la opacidad, el color
+     * clave y una copia de la tabla tomados al grabar.
+     * @param src Hoja indexada.
+     * @param rect Zona de `src`.
+     * @param alpha Opacidad de 1 a 255.
+     * @param key Índice transparente, o -1.
+     * @param lut Tabla de 256 colores en el formato de `dst`.
+     */
+    static void drawIndexedFrame(SDL_Surface *src, const SDL_Rect &rect, Uint8 alpha, int key,
+                                 const Uint32 *lut, SDL_Surface *dst, int x, int y);
+
+    /**
+     * @brief Mezcla una fila de 32 bits sobre el destino (SSE2/NEON).
+     * @param dst Fila destino.
+     * @param src Fila origen.
+     * @param n Número de píxeles.
+     * @param key Color clave del origen.
+     * @param useKey Si los píxeles con `key` se saltan.
+     * @param alpha Opacidad (255 = opaco).
+     * @param tint Multiplicador por canal en el formato del origen.
+     */
+    static void blendRow(Uint32 *dst, const Uint32 *src, int n, Uint32 key, bool useKey, Uint8 alpha, Uint32 tint);
+
+    /** @brief Versión escalar de referencia de `blendRow`, con el mismo resultado. */
+    static void blendRowScalar(Uint32 *dst, const Uint32 *src, int n, Uint32 key, bool useKey, Uint8 alpha, Uint32 tint);
     static void reverseAnimation(Sprite &sprite);
     static void zoom(Sprite &sprite, float x);
     static void stretchX(Sprite &sprite, float x);
@@ -0,0 +1,124 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <vector>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <Sprite.h>
+
+/**
+ * @file SpriteBatch.h
+ * @brief Dibujo por lotes de sprites con un solo bloqueo del destino.
+ */
+
+/**
+ * @class SpriteBatch
+ * @brief Acumula órdenes de dibujo de sprites y las ejecuta en una sola pasada.
+ *
+ * Pensado para escenas con miles de sprites pequeños, donde el coste fijo de
+ * cada `SDL_BlitSurface` (recorte, bloqueo y selección del blitter) pesa más
+ * que los propios píxeles:
+ * - Las órdenes se ordenan por capa y después por hoja de sprites.
+ * - El destino se bloquea una sola vez para todo el lote.
+ * - Las hojas de 32 bits se copian con un blitter propio que salta los tramos
+ *   del color key y copia los tramos opacos de golpe.
+ *
+ * Las hojas de 32 bits con RLE pierden el RLE la primera vez que pasan por
+ * un lote y usan el blitter propio. Las que no admite (otra profundidad o
+ * alpha) se dibujan con `SDL_BlitSurface` en su turno; si la orden lleva
+ * volteo, el frame se copia antes volteado a una superficie auxiliar que el
+ * lote reutiliza.
+ *
+ * @note Dentro de una misma capa solo se conserva el orden de llamada entre
+ *       sprites de la misma hoja; usar capas distintas cuando el solapamiento
+ *       entre hojas importe.
+ */
+class SpriteBatch {
+public:
+    /** @brief Constructor. */
+    SpriteBatch();
+
+    /** @brief Destructor. Libera la superficie auxiliar del volteo. */
+    ~SpriteBatch();
+
+    SpriteBatch(const SpriteBatch &) = delete;
+    SpriteBatch& operator=(const SpriteBatch &) = delete;
+
+    /**
+     * @brief Reserva espacio para un número de órdenes.
+     *
+     * El lote conserva su memoria entre frames, así que tras el primer frame
+     * (o tras reservar) no vuelve a reservar memoria.
+     * @param commands Número de órdenes esperado por frame.
+     */
+    void reserve(int commands);
+
+    /** @brief Descarta las órdenes acumuladas. */
+    void begin();
+
+    /**
+     * @brief Añade el frame actual de un sprite.
+     * @param sprite Sprite a dibujar.
+     * @param x Posición X en pantalla.
+     * @param y Posición Y en pantalla.
+     * @param flags Combinación de FLIP_HORIZONTAL y FLIP_VERTICAL.
+     * @param layer Capa de dibujo; las capas menores se dibujan antes.
+     */
+    void add(Sprite &sprite, int x, int y, int flags = 0, int layer = 0);
+
+    /**
+     * @brief Añade un frame concreto de un sprite.
+     * @param sprite Sprite a dibujar.
+     * @param frame Índice del frame.
+     * @param x Posición X en pantalla.
+     * @param y Posición Y en pantalla.
+     * @param flags Combinación de FLIP_HORIZONTAL y FLIP_VERTICAL.
+     * @param layer Capa de dibujo; las capas menores se dibujan antes.
+     */
+    void addFrame(Sprite &sprite, int frame, int x, int y, int flags = 0, int layer = 0);
+
+    /**
+     * @brief Ordena y dibuja todas las órdenes y vacía el lote.
+     * @param dst Superficie destino (normalmente `vram`).
+     * @return Número de sprites dibujados.
+     */
+    int end(SDL_Surface *dst);
+
+    /** @brief Número de órdenes pendientes. */
+    int size() const;
+
+private:
+    /** @brief Orden de dibujo. */
+    struct Command {
+        SDL_Surface *surface;   ///< Hoja de sprites.
+        SDL_Rect rect;          ///< Frame dentro de la hoja.
+        int x, y;               ///< Posición en pantalla.
+        int flags;              ///< FLIP_*.
+        int layer;              ///< Capa de dibujo.
+        Uint32 order;           ///< Orden de llegada, para desempatar.
+    };
+
+    /** @brief Criterio de orden: capa, hoja y orden de llegada. */
+    static bool compare(const Command &a, const Command &b);
+
+    /** @brief Indica si el blitter propio puede copiar de `src` a `dst`. */
+    static bool canSpanBlit(SDL_Surface *src, SDL_Surface *dst);
+
+    /**
+     * @brief Copia un frame de 32 bits con color key saltando tramos transparentes.
+     * @return false si el frame quedó fuera del área de recorte.
+     */
+    static bool spanBlit(const Command &cmd, SDL_Surface *dst, SDL_Rect *drawn);
+
+    /**
+     * @brief Dibuja con `SDL_BlitSurface` un frame volteado de una hoja que
+     *        no admite el blitter propio, a través de `scratch`.
+     * @return false si no se dibujó nada.
+     */
+    bool flippedBlit(const Command &cmd, SDL_Surface *dst, SDL_Rect *drawn);
+
+    std::vector<Command> commands;  ///< Órdenes del frame.
+    SDL_Surface *scratch;           ///< Frame volteado de `flippedBlit`.
+};
+
+#endif // SPRITEBATCH_H
@@ -0,0 +1,146 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Handle inválido devuelto cuando no se pudo crear una animación.
+ */
+#define ANIM_INVALID -1
+
+
+/**
+ * @brief Crea una animación.
+ *
+ * El estado de todas las animaciones (frame, dirección, velocidad y tiempo
+ * acumulado) se guarda en arreglos contiguos y se avanza en un solo recorrido
+ * con `anim_update()`. Solo avanzan las marcadas con `anim_tick()` desde la
+ * actualización anterior.
+ *
+ * @param frames Número de frames.
+ * @param speed Milisegundos por frame.
+ * @param running 1 para que empiece en marcha.
+ * @return Handle de la animación o `ANIM_INVALID` si no hay memoria.
+ */
+int anim_create(int frames, Uint32 speed, int running);
+
+/**
+ * @brief Libera una animación. Su handle puede reutilizarse.
+ *
+ * @param h Handle de la animación (se ignoran los handles inválidos).
+ */
+void anim_destroy(int h);
+
+/**
+ * @brief Marca una animación para que avance en el próximo `anim_update()`.
+ *
+ * Es lo que hace `Sprite::animate()`: una animación en marcha que no se
+ * marca se queda en su frame y no acumula tiempo mientras tanto.
+ */
+void anim_tick(int h);
+
+/**
+ * @brief Toma una muestra del reloj y avanza las animaciones en marcha
+ *        marcadas con `anim_tick()`, y quita las marcas.
+ *
+ * `Render()` la llama automáticamente una vez por frame, así que solo hay
+ * una llamada a `SDL_GetTicks()` por frame sin importar cuántos sprites haya.
+ */
+void anim_update();
+
+/**
+ * @brief Como `anim_update()` con un instante dado.
+ *
+ * @param now Tiempo en milisegundos (misma base que `SDL_GetTicks()`).
+ */
+void anim_update_ticks(Uint32 now);
+
+/**
+ * @brief Devuelve el tiempo de la última muestra del reloj.
+ */
+Uint32 anim_time();
+
+/**
+ * @brief Devuelve el frame actual de una animación.
+ */
+int anim_frame(int h);
+
+/**
+ * @brief Cambia el frame actual y reinicia el tiempo acumulado.
+ */
+void anim_set_frame(int h, int frame);
+
+/**
+ * @brief Devuelve la dirección de avance (1 o -1).
+ */
+int anim_direction(int h);
+
+/**
+ * @brief Cambia el número de frames. El frame actual se ajusta si queda fuera.
+ */
+void anim_set_frames(int h, int frames);
+
+/**
+ * @brief Devuelve la velocidad en milisegundos por frame.
+ */
+Uint32 anim_speed(int h);
+
+/**
+ * @brief Cambia la velocidad en milisegundos por frame.
+ */
+void anim_set_speed(int h, Uint32 speed);
+
+/**
+ * @brief Define qué pasa al llegar al último frame.
+ *
+ * @param h Handle de la animación.
+ * @param loop 1 para volver al primer frame, 0 para invertir la dirección
+ *             (ida y vuelta).
+ */
+void anim_set_loop(int h, int loop);
+
+/**
+ * @brief Pone en marcha o detiene una animación sin cambiar su frame.
+ */
+void anim_set_running(int h, int running);
+
+/**
+ * @brief Indica si una animación está en marcha.
+ */
+int anim_running(int h);
+
+/**
+ * @brief Vuelve al primer frame, hacia delante y con el tiempo acumulado a 0.
+ */
+void anim_restart(int h);
+
+/**
+ * @brief Número de animaciones creadas.
+ */
+int anim_count();
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef CMDLIST_H_
+#define CMDLIST_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @file cmdlist.h
+ * @brief Partes comunes de los grabadores de órdenes (`deferred.h` y
+ *        `render_queue.h`).
+ *
+ * Cada grabador guarda sus propias órdenes; aquí van el recorte de la caja
+ * contra el destino, los textos, las superficies retenidas hasta el final
+ * del frame, la memoria de los contextos y las primitivas de SDL_gfx.
+ */
+
+
+/**
+ * @name Primitivas de SDL_gfx
+ *
+ * Las de dos puntos usan `(x1, y1)-(x2, y2)`; los círculos usan `(x1, y1)`
+ * como centro y `x2` como radio.
+ * @{
+ */
+#define CMDLIST_LINE			0
+#define CMDLIST_RECT			1
+#define CMDLIST_BOX				2
+#define CMDLIST_CIRCLE			3
+#define CMDLIST_FILLED_CIRCLE	4
+/** @} */
+
+
+/**
+ * @brief Superficie retenida por una grabación.
+ */
+typedef struct {
+	SDL_Surface *surf;
+	int rle;			///< Se le quitó el RLE al grabar; `cmdlist_reset` lo devuelve.
+} cmdlist_pin;
+
+/**
+ * @brief Estado compartido de una grabación. Se inicializa a cero.
+ */
+typedef struct {
+	char *text;						///< Textos copiados, terminados en 0.
+	int text_len, text_cap;
+	cmdlist_pin *pins;				///< Superficies con una referencia extra.
+	int pin_count, pin_cap;
+	u8 **chunks;					///< Bloques fijos de `cmdlist_alloc`.
+	int chunk_count, chunk_cap, chunk_cur, chunk_used;
+} cmdlist;
+
+
+/**
+ * @brief Asegura sitio para `need` elementos de `size` bytes en `items`.
+ *
+ * La capacidad crece al doble (mínimo 64).
+ *
+ * @return El array, quizá movido, o NULL sin memoria (el anterior sigue
+ *         siendo válido y `*cap` no cambia).
+ */
+void *cmdlist_grow(void *items, int *cap, int need, int size);
+
+/**
+ * @brief Recorta la caja `[x1,x2) x [y1,y2)` contra el área de recorte de
+ *        `dst`.
+ *
+ * @return 0 si no queda nada visible.
+ */
+int cmdlist_clip(const SDL_Surface *dst, int *x1, int *y1, int *x2, int *y2);
+
+/**
+ * @brief Copia `text` con su 0 final.
+ *
+ * @return Desplazamiento en `l->text`, o -1 sin memoria.
+ */
+int cmdlist_text(cmdlist *l, const char *text);
+
+/**
+ * @brief Suma una referencia a `s` que se quita en `cmdlist_reset`.
+ *
+ * `SDL_FreeSurface` solo libera cuando `refcount` llega a 0, así que la
+ * superficie sigue viva aunque su dueño la libere antes.
+ *
+ * @return Índice en `l->pins`, o -1 sin memoria.
+ */
+int cmdlist_keep(cmdlist *l, SDL_Surface *s);
+
+/**
+ * @brief Reserva memoria que dura hasta `cmdlist_reset`.
+ *
+ * Los bloques no se mueven ni se liberan, solo se reutilizan.
+ *
+ * @return Bloque alineado a 8 bytes, o NULL si `size` no cabe en un bloque
+ *         de 16 KB o no hay memoria.
+ */
+void *cmdlist_alloc(cmdlist *l, int size);
+
+/**
+ * @brief Vacía los textos y la memoria y suelta las superficies retenidas.
+ */
+void cmdlist_reset(cmdlist *l);
+
+/**
+ * @brief Caja `[x1,x2) x [y1,y2)` que puede tocar una primitiva `CMDLIST_*`.
+ */
+void cmdlist_prim_bounds(int kind, int x1, int y1, int x2, int y2, int *bx1, int *by1, int *bx2, int *by2);
+
+/**
+ * @brief Dibuja una primitiva `CMDLIST_*` en `dst` desplazada `(-ox, -oy)`.
+ *
+ * @param rgba Color en formato 0xRRGGBBAA.
+ */
+void cmdlist_prim_draw(SDL_Surface *dst, int kind, int x1, int y1, int x2, int y2, int ox, int oy, u32 rgba);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef DEFERRED_H_
+#define DEFERRED_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Lado de los tiles en píxeles.
+ *
+ * Cada tile se dibuja entero en un solo hilo; con 64x64 una pantalla de
+ * 320x240 tiene 20 tiles, suficientes para repartir entre 4-8 núcleos.
+ */
+#define DEFERRED_TILE 64
+
+/**
+ * @name Volteos de `deferred_blit_ex` (mismos valores que `FLIP_*` de Sprite.h)
+ * @{
+ */
+#define DEFERRED_FLIP_H 1
+#define DEFERRED_FLIP_V 2
+/** @} */
+
+
+/**
+ * @brief Orden de dibujo personalizada, ejecutada una vez por tile.
+ *
+ * @param view Superficie que cubre la parte de `bounds` dentro del tile
+ *             (comparte píxeles con el destino y recorta a sus bordes).
+ * @param ox Posición X de `view` en el destino; restarla a las coordenadas.
+ * @param oy Posición Y de `view` en el destino.
+ * @param ctx Contexto pasado a `deferred_call`.
+ *
+ * @note Se llama desde varios hilos a la vez (sobre tiles distintos), así
+ *       que no debe modificar estado compartido.
+ */
+typedef void (*deferred_func)(SDL_Surface *view, int ox, int oy, void *ctx);
+
+
+/**
+ * @brief Empieza a grabar órdenes de dibujo para `dst`.
+ *
+ * Las órdenes no tocan `dst` hasta `deferred_end()`. Allí se reparten en
+ * tiles de `DEFERRED_TILE` píxeles y los tiles se dibujan en paralelo con
+ * el pool de hilos; dentro de cada tile se respeta el orden de grabación.
+ * Como los tiles no se solapan, no hace falta ningún bloqueo sobre `dst`.
+ *
+ * @param dst Superficie destino (normalmente `vram`).
+ * @return 0 si se pudo empezar, -1 si `dst` no es válida.
+ */
+int deferred_begin(SDL_Surface *dst);
+
+/**
+ * @brief Graba la copia de una zona de `src` en `(x, y)`.
+ *
+ * Las superficies de 32 bits con el mismo formato RGB que el destino (con
+ * color key, alpha por superficie o alpha por píxel) se dibujan en paralelo.
+ * Las hojas con color key en RLE se decodifican una vez aquí para poder
+ * leerlas desde varios hilos y recuperan el RLE en `deferred_end()`; si una
+ * hoja se dibuja también sin diferir en cada frame, SDL la vuelve a
+ * codificar en cada uno. El resto se dibuja con
+ * `SDL_BlitSurface` en el hilo principal, en su turno: los tiles se dibujan
+ * hasta esa orden, se ejecuta y se sigue. En ese caso se ignoran el volteo,
+ * el alpha y el tinte de `deferred_blit_ex`.
+ *
+ * El color key y el alpha de `src` se toman al grabar, y `src` se mantiene
+ * viva hasta `deferred_end()` aunque se libere antes (ver `deferred_keep`).
+ * Sus píxeles, en cambio, se leen al dibujar: no deben modificarse mientras
+ * haya órdenes pendientes.
+ *
+ * @param src Superficie origen.
+ * @param srect Zona de `src`, o NULL para toda la superficie.
+ * @param x Posición X en el destino.
+ * @param y Posición Y en el destino.
+ */
+void deferred_blit(SDL_Surface *src, const SDL_Rect *srect, int x, int y);
+
+/**
+ * @brief Como `deferred_blit` con volteo, alpha y tinte.
+ *
+ * @param flags Combinación de `DEFERRED_FLIP_H` y `DEFERRED_FLIP_V`.
+ * @param alpha Opacidad de 0 a 255.
+ * @param tint Tinte en formato 0xRRGGBB (0xFFFFFF sin tinte), multiplicado
+ *             por canal como en `Sprite::setTint`.
+ */
+void deferred_blit_ex(SDL_Surface *src, const SDL_Rect *srect, int x, int y,
+		int flags, Uint8 alpha, u32 tint);
+
+/**
+ * @brief Graba el relleno de un rectángulo (NULL: todo el destino).
+ *
+ * @param color Color ya convertido al formato del destino.
+ */
+void deferred_fill(const SDL_Rect *rect, u32 color);
+
+/**
+ * @brief Graba un texto con la fuente incorporada (ver `print`).
+ *
+ * Se usa el tamaño de `fontsize()` vigente al grabar.
+ */
+void deferred_text(int x, int y, const char *text, u32 color);
+
+/**
+ * @name Primitivas de SDL_gfx (color en formato 0xRRGGBBAA)
+ * @{
+ */
+void deferred_line(int x1, int y1, int x2, int y2, u32 rgba);
+void deferred_rect(int x1, int y1, int x2, int y2, u32 rgba);
+void deferred_box(int x1, int y1, int x2, int y2, u32 rgba);
+void deferred_circle(int x, int y, int r, u32 rgba);
+void deferred_filled_circle(int x, int y, int r, u32 rgba);
+/** @} */
+
+/**
+ * @brief Graba una orden personalizada.
+ *
+ * @param fn Función que dibuja sobre cada tile tocado por `bounds`.
+ * @param ctx Contexto para `fn`; debe seguir vivo hasta `deferred_end()`.
+ * @param bounds Zona del destino que puede modificar (NULL: todo).
+ */
+void deferred_call(deferred_func fn, void *ctx, const SDL_Rect *bounds);
+
+/**
+ * @brief Mantiene viva una superficie hasta `deferred_end()`.
+ *
+ * Suma una referencia (`refcount`) que se quita al terminar, así que un
+ * `SDL_FreeSurface` durante la grabación no la libera todavía. Las órdenes
+ * de `deferred_call` que leen superficies deben pedirlo al grabar.
+ *
+ * @return 0 si se pudo, -1 si no hay grabación en curso o memoria.
+ */
+int deferred_keep(SDL_Surface *s);
+
+/**
+ * @brief Reserva memoria para el contexto de una orden.
+ *
+ * La memoria dura hasta `deferred_end()` y se reutiliza en la siguiente
+ * grabación, así que sirve para los datos por llamada de `deferred_call`.
+ *
+ * @return Bloque alineado a 8 bytes, o NULL si no hay grabación en curso.
+ */
+void *deferred_alloc(int size);
+
+/**
+ * @brief Dibuja todas las órdenes grabadas y termina la grabación.
+ *
+ * Registra las zonas dibujadas como sucias si el destino es `vram`.
+ *
+ * @return Número de órdenes dibujadas.
+ */
+int deferred_end();
+
+/**
+ * @brief Indica si hay una grabación en curso.
+ */
+int deferred_active();
+
+/**
+ * @brief Superficie que se está grabando, o NULL si no hay grabación.
+ *
+ * `Sprite::draw`, `GfxTexture::render` y `print` la consultan para grabar
+ * en lugar de dibujar cuando su destino es esta superficie.
+ */
+SDL_Surface *deferred_target();
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
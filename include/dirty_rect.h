@@ -0,0 +1,127 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef DIRTY_RECT_H_
+#define DIRTY_RECT_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Número máximo de rectángulos sucios por frame.
+ *
+ * Si se supera este límite el frame completo se considera sucio y `Render()`
+ * vuelve a presentar toda la pantalla.
+ */
+#define DIRTY_MAX_RECTS 64
+
+/**
+ * @brief Área extra (en píxeles) que se tolera al fusionar dos rectángulos.
+ *
+ * Dos rectángulos se fusionan si el área de su unión no supera la suma de sus
+ * áreas más este margen. Así se unen rectángulos solapados o contiguos sin
+ * acabar subiendo grandes zonas que no cambiaron.
+ */
+#define DIRTY_MERGE_SLACK 256
+
+
+/**
+ * @brief Activa o desactiva el seguimiento de regiones sucias.
+ *
+ * Con el seguimiento activo, `Render()` presenta solo los rectángulos
+ * registrados durante el frame mediante `SDL_UpdateRects` en lugar de
+ * `SDL_Flip`. Al cambiar el estado la pantalla completa se marca como sucia.
+ *
+ * @param enable 1 para activar, 0 para desactivar (por defecto desactivado).
+ */
+void dirty_rect_enable(int enable);
+
+/**
+ * @brief Indica si el seguimiento de regiones sucias está activo.
+ *
+ * @return 1 si está activo, 0 en caso contrario.
+ */
+int dirty_rect_enabled();
+
+/**
+ * @brief Registra un rectángulo modificado de una superficie.
+ *
+ * Solo se registran los cambios sobre `vram`; cualquier otra superficie se
+ * ignora. El rectángulo se recorta a la pantalla y se fusiona con los ya
+ * registrados cuando es posible.
+ *
+ * @param dst Superficie sobre la que se dibujó.
+ * @param rect Rectángulo modificado (típicamente el `dstrect` devuelto por
+ *             `SDL_BlitSurface`). Si es NULL se marca la superficie completa.
+ */
+void dirty_rect_add(SDL_Surface *dst, const SDL_Rect *rect);
+
+/**
+ * @brief Registra un rectángulo modificado dado por posición y tamaño.
+ *
+ * @param dst Superficie sobre la que se dibujó.
+ * @param x Coordenada X de la esquina superior izquierda.
+ * @param y Coordenada Y de la esquina superior izquierda.
+ * @param w Ancho en píxeles.
+ * @param h Alto en píxeles.
+ */
+void dirty_rect_add_xywh(SDL_Surface *dst, int x, int y, int w, int h);
+
+/**
+ * @brief Registra la región delimitada por dos esquinas (inclusive).
+ *
+ * Las esquinas pueden venir en cualquier orden, como en las primitivas de
+ * SDL_gfx.
+ *
+ * @param dst Superficie sobre la que se dibujó.
+ * @param x1 Coordenada X de la primera esquina.
+ * @param y1 Coordenada Y de la primera esquina.
+ * @param x2 Coordenada X de la segunda esquina.
+ * @param y2 Coordenada Y de la segunda esquina.
+ */
+void dirty_rect_add_bounds(SDL_Surface *dst, int x1, int y1, int x2, int y2);
+
+/**
+ * @brief Marca la pantalla completa como sucia.
+ *
+ * Se usa tras operaciones que tocan todo el framebuffer, como `cls()`.
+ */
+void dirty_rect_add_all();
+
+/**
+ * @brief Obtiene los rectángulos sucios acumulados en el frame.
+ *
+ * @param count Puntero donde se guarda el número de rectángulos.
+ * @return Puntero al arreglo interno de rectángulos (válido hasta la
+ *         siguiente llamada a `dirty_rect_clear`).
+ */
+SDL_Rect *dirty_rect_get(int *count);
+
+/**
+ * @brief Vacía la lista de rectángulos sucios.
+ *
+ * `Render()` la llama automáticamente después de presentar el frame.
+ */
+void dirty_rect_clear();
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
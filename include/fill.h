@@ -0,0 +1,104 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef FILL_H_
+#define FILL_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Tamaño (en bytes) a partir del cual se usan escrituras no temporales.
+ *
+ * Un relleno más grande que la caché solo sirve para expulsar datos útiles,
+ * así que por encima de este tamaño se escribe directamente a memoria
+ * (`movntdq` en x86). Definir a 0 para desactivarlas.
+ */
+#ifndef FILL_STREAM_BYTES
+#define FILL_STREAM_BYTES (4 * 1024 * 1024)
+#endif
+
+
+/**
+ * @brief Rellena `n` píxeles de 32 bits consecutivos con un color.
+ *
+ * Usa escrituras alineadas de 128/256 bits (SSE2, AVX2 o NEON según el
+ * compilador) y resuelve los extremos sin alinear píxel a píxel.
+ *
+ * @param dst Primer píxel a escribir.
+ * @param color Valor del píxel ya en el formato de destino.
+ * @param n Número de píxeles.
+ */
+void fill_span32(u32 *dst, u32 color, int n);
+
+/**
+ * @brief Rellena `n` píxeles de 32 bits alternando dos colores.
+ *
+ * El primer píxel recibe `c1`, el segundo `c2`, y así sucesivamente.
+ */
+void fill_span32_pattern(u32 *dst, u32 c1, u32 c2, int n);
+
+/**
+ * @brief Rellena `n` píxeles consecutivos de cualquier profundidad.
+ *
+ * @param dst Primer píxel a escribir (alineado al tamaño del píxel).
+ * @param bpp Bytes por píxel (1 a 4).
+ * @param color Valor del píxel ya en el formato de destino.
+ * @param n Número de píxeles.
+ */
+void fill_span(void *dst, int bpp, u32 color, int n);
+
+/**
+ * @brief Rellena un rectángulo de una superficie con un color.
+ *
+ * Equivale a `SDL_FillRect`: el rectángulo se recorta contra el área de
+ * recorte de la superficie y se respeta el `pitch` de cada fila. Funciona con
+ * superficies de 8, 16, 24 y 32 bits y bloquea la superficie si hace falta.
+ * Si el destino es `vram` la zona se registra como sucia.
+ *
+ * @param dst Superficie destino.
+ * @param rect Rectángulo a rellenar, o NULL para toda la superficie.
+ * @param color Color ya convertido con `SDL_MapRGB` al formato de `dst`.
+ */
+void fill_rect(SDL_Surface *dst, const SDL_Rect *rect, u32 color);
+
+/**
+ * @brief Rellena la superficie completa con un color.
+ *
+ * Si las filas son contiguas (`pitch == w * bpp`) se escribe toda la
+ * superficie de una sola pasada.
+ *
+ * @param dst Superficie destino.
+ * @param color Color ya convertido al formato de `dst`.
+ */
+void fill_surface(SDL_Surface *dst, u32 color);
+
+/**
+ * @brief Rellena un área de `w` x `h` píxeles con un damero de 1 píxel.
+ *
+ * Los píxeles con `(x + y)` par reciben `c1` y los impares `c2`. Solo admite
+ * superficies de 32 bits.
+ */
+void fill_checker(SDL_Surface *dst, int w, int h, u32 c1, u32 c2);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
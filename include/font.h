@@ -12,6 +12,8 @@
 #ifndef FONT_H_
 #define FONT_H_
 
+#include <SDL/SDL.h>
+
 
 #ifdef __cplusplus
 
@@ -34,6 +36,30 @@ extern "C" {
 void caracter(int x, int y, const char ascii, unsigned int color);
 
 
+/**
+ * @brief Dibuja un carácter en cualquier superficie con un tamaño de celda dado.
+ *
+ * No usa el estado global de `fontsize()` ni registra regiones sucias:
+ * escribe los píxeles directamente, sin `pixel()`, así que puede llamarse
+ * desde varios hilos sobre superficies distintas (incluida `vram`).
+ *
+ * @param dst Superficie de 32 bits destino.
+ * @param x Coordenada X de la celda.
+ * @param y Coordenada Y de la celda.
+ * @param w Ancho de la celda (como en `fontsize()`).
+ * @param h Alto de la celda (como en `fontsize()`).
+ * @param ascii Carácter a dibujar.
+ * @param color Color del carácter.
+ */
+void caracter_surface(SDL_Surface *dst, int x, int y, int w, int h, const char ascii, unsigned int color);
+
+
+/**
+ * @brief Devuelve el tamaño de celda fijado con `fontsize()`.
+ */
+void font_get_size(int *w, int *h);
+
+
 /**
  * @brief Establece el tamaño de fuente para la impresión de texto.
  *
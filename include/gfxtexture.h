@@ -3,7 +3,10 @@
 
 #include <SDL/SDL.h>
 #include <string>
+#include <list>
+#include <map>
 #include <types.h>				// Definiciones de u8, u32, etc.
+#include <SheetRegistry.h>
 
 /**
  * @class GfxTexture
@@ -24,6 +27,10 @@ class GfxTexture
 	/** @brief Destructor. Libera memoria usada por las superficies. */
 	~GfxTexture();
 
+	/** @brief Las texturas no se copian: la imagen base puede estar compartida. */
+	GfxTexture(const GfxTexture &) = delete;
+	GfxTexture & operator=(const GfxTexture &) = delete;
+
 	/**
      * @brief Inicializa una superficie vacía con el tamaño dado.
      * @param w Ancho en píxeles.
@@ -34,6 +41,9 @@ class GfxTexture
 
 	/**
      * @brief Carga una imagen desde un archivo.
+     *
+     * Las texturas que cargan el mismo archivo comparten la imagen hasta que
+     * una de ellas la modifica.
      * @param filename Ruta del archivo.
      * @return true si la carga fue exitosa, false si hubo error.
      */
@@ -96,6 +106,13 @@ class GfxTexture
      */
 	void fill_vertical_gradient(Uint32 color1, Uint32 color2);
 
+	/**
+     * @brief Aplica un gradiente radial del centro a las esquinas.
+     * @param color1 Color del centro.
+     * @param color2 Color de las esquinas.
+     */
+	void fill_radial_gradient(Uint32 color1, Uint32 color2);
+
 	/**
      * @brief Aplica transparencia a un color clave (color key).
      * @param r Componente roja.
@@ -105,14 +122,102 @@ class GfxTexture
 	void applyTransparency(Uint8 r, Uint8 g, Uint8 b);
 
 
-	void rotozoom();			// /< Aplica rotación y escala a la textura
+	/**
+     * @brief Aplica rotación y escala a la textura.
+     *
+     * No hace nada si desde la última llamada no cambiaron la rotación, la
+     * escala ni el contenido de la superficie base. `render()` la llama por sí
+     * sola cuando hace falta, así que llamarla cada frame ya no cuesta nada.
+     */
+	void rotozoom();
+
+	/**
+     * @brief Marca la superficie base como modificada.
+     *
+     * Los métodos `fill*`, `set_surface` y las cargas lo hacen solos; solo hace
+     * falta llamarlo tras escribir en `get_surface()` directamente. Vacía la
+     * caché y fuerza el siguiente `rotozoom()`.
+     */
+	void invalidate();
+
+	/**
+     * @brief Activa el modo de superficie de salida persistente.
+     *
+     * En este modo `rotozoom()` ya no libera y crea una superficie nueva en
+     * cada llamada: conserva un único buffer del tamaño máximo usado hasta
+     * ahora y transforma dentro de él. El color key se asigna solo cuando el
+     * buffer crece.
+     * @param enable true para reutilizar el buffer, false para el modo clásico.
+     */
+	void set_persistent(bool enable);
+
+	/**
+     * @brief Activa la caché de superficies rotadas/escaladas.
+     *
+     * Con la caché activa, `rotozoom()` cuantiza el ángulo a `angle_steps`
+     * pasos por vuelta y la escala a `scale_steps` cubos logarítmicos por cada
+     * duplicación de tamaño, y guarda el resultado. Si el mismo par vuelve a
+     * pedirse, el render es un simple blit. Cuando se supera `max_bytes` se
+     * descartan las superficies usadas hace más tiempo (LRU). Las escalas
+     * negativas (volteo) no se guardan en caché.
+     * @param max_bytes Memoria máxima para las superficies guardadas.
+     * @param angle_steps Pasos de ángulo por vuelta completa.
+     * @param scale_steps Cubos de escala por cada factor 2.
+     */
+	void enable_cache(u32 max_bytes, int angle_steps = 256, int scale_steps = 8);
+
+	/** @brief Desactiva la caché y libera sus superficies. */
+	void disable_cache();
+
+	/** @brief Libera las superficies guardadas sin desactivar la caché. */
+	void clear_cache();
+
+	/**
+     * @brief Llena la caché por adelantado, pensado para el tiempo de carga.
+     *
+     * Calcula todos los pasos de ángulo para cada cubo de escala entre
+     * `min_scale` y `max_scale` (ambos incluidos). Se detiene al llenar la
+     * memoria configurada en lugar de expulsar lo ya calculado.
+     * @param min_scale Escala mínima.
+     * @param max_scale Escala máxima.
+     * @return Número de superficies presentes en la caché para ese rango.
+     */
+	int prebake(float min_scale, float max_scale);
+
+	/** @brief Memoria usada actualmente por la caché, en bytes. */
+	u32 cache_bytes() const
+	{
+		return cache_used;
+	}
 
 	/**
      * @brief Renderiza la textura en la superficie destino.
+     *
+     * Si la rotación, la escala o el contenido cambiaron desde el último
+     * `rotozoom()`, lo recalcula antes de dibujar. Los cambios de posición o
+     * alpha no requieren recalcular nada. Si `dst` es `deferred_target()`
+     * o `render_queue_target()` la copia se graba en el renderizador
+     * diferido o en la cola (capa `render_queue_layer()`) con la rotación y
+     * el alpha actuales.
      * @param dst Superficie donde se dibujará.
      */
 	void render(SDL_Surface * dst);
 
+	/**
+     * @brief Dibuja la textura rotada y escalada directamente en el destino.
+     *
+     * Recorre las líneas del destino dentro del área transformada, toma cada
+     * píxel de la superficie base con la transformación inversa y lo compone
+     * (color key negro y alpha global) en la misma pasada, sin superficie
+     * intermedia ni `rotozoom()` previo. El resultado es el mismo que
+     * `rotozoom()` seguido de `render()`. Si los formatos no permiten la ruta
+     * directa (no 32 bits, distinto orden RGB o alpha por píxel), o si se
+     * está grabando sobre `dst` con el renderizador diferido o la cola, se usa esa
+     * ruta clásica.
+     * @param dst Superficie donde se dibujará.
+     */
+	void render_direct(SDL_Surface * dst);
+
 	/**
      * @brief Define la posición donde se renderizará.
      * @param x Coordenada X.
@@ -173,18 +278,54 @@ class GfxTexture
 	void set_surface(SDL_Surface * src, int x, int y);
 
   private:
+	/** @brief Partes que `rotozoom()` debe recalcular. */
+	enum
+	{
+		DIRTY_GEOMETRY = 1,		// /< Cambió la rotación o la escala.
+		DIRTY_CONTENT = 2		// /< Cambió la superficie base.
+	};
+
+	/** @brief Superficie transformada guardada en la caché. */
+	struct CacheEntry
+	{
+		u32 key;				// /< Ángulo y escala cuantizados.
+		SDL_Surface *surf;		// /< Resultado con color key aplicado.
+		int applied_alpha;		// /< Último alpha aplicado a `surf`.
+		u32 bytes;				// /< Memoria ocupada por `surf`.
+	};
+	typedef std::list < CacheEntry > CacheList;
+
 	void free_surface(SDL_Surface * &surf);	// /< Libera memoria de una
 	// superficie.
 	void update_pixels();		// /< Actualiza puntero rápido a píxeles.
+	bool make_unique();			// /< Copia la imagen base si está compartida.
+	void rotozoom_persistent();	// /< rotozoom() sobre el buffer reutilizable.
+	bool rotozoom_cached();		// /< rotozoom() a través de la caché.
+	CacheEntry *cache_fetch(int angle_index, int scale_index, bool evict);
+	int cache_angle_index(float angle) const;
+	int cache_scale_index(float zoom) const;
 
 	SDL_Surface *surface;		// /< Superficie procesada (rotada/escalada).
-	SDL_Surface *work_surface;	// /< Superficie base editable.
+	int surface_w, surface_h;	// /< Área usada de `surface`.
+	bool persistent;			// /< Reutiliza `surface` entre llamadas.
+	int applied_alpha;			// /< Último alpha aplicado a `surface` (-1 
+	// ninguno).
+	SheetHandle work;			// /< Propiedad (compartida) de la imagen base.
+	SDL_Surface *work_surface;	// /< Superficie base editable (`work.get()`).
 	u32 *pixels;				// /< Puntero rápido a píxeles para
 	// edición.
 	int x, y;					// /< Posición de renderizado.
 	u8 alpha;					// /< Transparencia global.
 	float rotation;				// /< Ángulo de rotación.
 	float scale;				// /< Escala relativa.
+	CacheList cache;			// /< Caché LRU, la más reciente al frente.
+	std::map < u32, CacheList::iterator > cache_index;	// /< Clave -> entrada.
+	CacheEntry *cache_current;	// /< Entrada usada por render() (o NULL).
+	u32 cache_limit;			// /< Memoria máxima de la caché (0 = apagada).
+	u32 cache_used;				// /< Memoria usada por la caché.
+	int cache_angle_steps;		// /< Pasos de ángulo por vuelta.
+	int cache_scale_steps;		// /< Cubos de escala por factor 2.
+	u8 dirty;					// /< Combinación de DIRTY_*.
 };
 
 #endif // GFXTEXTURE_H
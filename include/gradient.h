@@ -0,0 +1,74 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef GRADIENT_H_
+#define GRADIENT_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Número de tonos de la rampa usada por el gradiente radial.
+ */
+#define GRADIENT_RADIAL_STEPS 256
+
+
+/**
+ * @brief Precalcula una rampa de colores entre `c1` y `c2`.
+ *
+ * Los dos colores se descomponen una sola vez y la interpolación se hace en
+ * punto fijo 16.16; cada entrada queda ya convertida al formato `fmt`.
+ *
+ * @param fmt Formato de los colores de entrada y de salida.
+ * @param c1 Color de la primera entrada.
+ * @param c2 Color de la última entrada.
+ * @param lut Tabla de salida con espacio para `n` colores.
+ * @param n Número de entradas.
+ */
+void gradient_ramp(SDL_PixelFormat *fmt, u32 c1, u32 c2, u32 *lut, int n);
+
+/**
+ * @brief Gradiente horizontal de `c1` (izquierda) a `c2` (derecha).
+ *
+ * Se genera la primera fila y se copia al resto, recorriendo la superficie
+ * por filas.
+ */
+void gradient_horizontal(SDL_Surface *dst, u32 c1, u32 c2);
+
+/**
+ * @brief Gradiente vertical de `c1` (arriba) a `c2` (abajo).
+ *
+ * Cada fila es un color liso y se rellena con `fill_span`.
+ */
+void gradient_vertical(SDL_Surface *dst, u32 c1, u32 c2);
+
+/**
+ * @brief Gradiente radial de `c1` (centro) a `c2` (esquinas).
+ *
+ * La distancia se compara al cuadrado contra umbrales precalculados, sin
+ * `sqrt` por píxel, y se aprovecha la simetría respecto al centro: solo se
+ * calcula media fila y las filas simétricas se copian.
+ */
+void gradient_radial(SDL_Surface *dst, u32 c1, u32 c2);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef JOB_POOL_H_
+#define JOB_POOL_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Número máximo de hilos (incluido el que llama) que usa el pool.
+ */
+#define JOB_POOL_MAX_THREADS 16
+
+/**
+ * @brief Trabajo que procesa el rango de elementos `[first, last)`.
+ *
+ * @param ctx Contexto del trabajo, compartido por todos los hilos (solo lectura
+ *            o escrituras en zonas disjuntas).
+ * @param first Primer elemento del rango.
+ * @param last Elemento siguiente al último del rango.
+ */
+typedef void (*job_func)(void *ctx, int first, int last);
+
+
+/**
+ * @brief Crea los hilos de trabajo persistentes.
+ *
+ * Los hilos se crean una sola vez y quedan dormidos esperando trabajo, así
+ * `job_pool_for()` no paga la creación de hilos en cada llamada.
+ * `Init_Sistem()` lo llama automáticamente.
+ *
+ * @param threads Número total de hilos, contando el que llama. Si es 0 o
+ *                negativo se usa el número de CPUs; 1 desactiva el pool.
+ * @return Número de hilos en uso.
+ */
+int job_pool_init(int threads);
+
+/**
+ * @brief Detiene y libera los hilos de trabajo.
+ *
+ * `shoutdown_sistem()` lo llama automáticamente. Después de esta llamada
+ * `job_pool_for()` ejecuta todo en el hilo que llama.
+ */
+void job_pool_quit();
+
+/**
+ * @brief Número de hilos en uso, contando el que llama.
+ *
+ * @return 1 si el pool no está iniciado o está desactivado.
+ */
+int job_pool_threads();
+
+/**
+ * @brief Reparte `[0, count)` en rangos contiguos entre los hilos del pool.
+ *
+ * El hilo que llama procesa el primer rango y espera a que terminen los
+ * demás. Si el pool no está iniciado, está ocupado con otro reparto o la
+ * llamada viene de un hilo del propio pool, todo se ejecuta en el hilo que
+ * llama, por lo que la función es segura desde varios hilos.
+ *
+ * @param func Trabajo a ejecutar.
+ * @param ctx Contexto que se pasa a `func`.
+ * @param count Número de elementos (por ejemplo filas).
+ */
+void job_pool_for(job_func func, void *ctx, int count);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
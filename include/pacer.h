@@ -0,0 +1,171 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef PACER_H_
+#define PACER_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Número de frames que guarda la ventana de estadísticas (10 s a 60 Hz).
+ */
+#define PACER_HISTORY 600
+
+/**
+ * @brief Resolución del histograma de tiempos de frame, en nanosegundos.
+ */
+#define PACER_BUCKET_NS 10000
+
+/**
+ * @brief Número de cubetas del histograma. Los frames más largos que
+ *        `PACER_BUCKETS * PACER_BUCKET_NS` (≈41 ms) caen en la última.
+ */
+#define PACER_BUCKETS 4096
+
+/**
+ * @brief Límites del margen de espera activa, en nanosegundos.
+ *
+ * El margen se ajusta solo según cuánto se pasa el sistema al dormir.
+ */
+#define PACER_SPIN_MIN 200000
+#define PACER_SPIN_MAX 4000000
+
+
+/**
+ * @brief Estadísticas de los últimos `PACER_HISTORY` frames.
+ *
+ * Los percentiles tienen la resolución de `PACER_BUCKET_NS`; `worst` y `mean`
+ * son exactos. Todos los tiempos están en nanosegundos.
+ */
+typedef struct {
+	Uint64 p50;			///< Mediana del tiempo entre frames.
+	Uint64 p95;			///< Percentil 95.
+	Uint64 p99;			///< Percentil 99.
+	Uint64 worst;		///< Frame más largo de la ventana.
+	Uint64 mean;		///< Media de la ventana.
+	int samples;		///< Frames en la ventana.
+	int dropped;		///< Pasos de lógica descartados por el límite de frame-skip.
+} pacer_stats;
+
+
+/**
+ * @brief Reloj monotónico en nanosegundos.
+ *
+ * Usa `clock_gettime(CLOCK_MONOTONIC)` o `QueryPerformanceCounter` según la
+ * plataforma; donde no hay nada mejor cae a `SDL_GetTicks()`.
+ */
+Uint64 pacer_now_ns();
+
+/**
+ * @brief Fija la frecuencia de presentación.
+ *
+ * @param hz Frames por segundo; 0 desactiva la espera.
+ */
+void pacer_set_rate(int hz);
+
+/**
+ * @brief Fija el periodo de presentación en nanosegundos (0 sin espera).
+ */
+void pacer_set_period_ns(Uint64 ns);
+
+/**
+ * @brief Activa o desactiva la espera sin tocar el periodo configurado.
+ *
+ * Con la espera desactivada `pacer_wait()` vuelve en seguida pero sigue
+ * registrando los tiempos, así las estadísticas miden la velocidad máxima.
+ *
+ * @param enable 1 para esperar (por defecto), 0 para correr sin límite.
+ */
+void pacer_set_enabled(int enable);
+
+/**
+ * @brief Fija la frecuencia de la lógica de paso fijo.
+ *
+ * Por defecto es 60 Hz, independiente de la frecuencia de presentación.
+ */
+void pacer_set_step_rate(int hz);
+
+/**
+ * @brief Número máximo de pasos de lógica por frame (frame-skip).
+ *
+ * Si el juego se queda atrás más de `steps` pasos, el tiempo sobrante se
+ * descarta en lugar de intentar recuperarlo a ráfagas.
+ */
+void pacer_set_max_steps(int steps);
+
+/**
+ * @brief Marca el inicio de un frame y acumula el tiempo transcurrido.
+ *
+ * Uso típico:
+ * @code
+ * pacer_begin_frame();
+ * while (pacer_step())
+ *     update(pacer_step_seconds());
+ * draw(pacer_alpha());
+ * Render();
+ * pacer_wait();
+ * @endcode
+ */
+void pacer_begin_frame();
+
+/**
+ * @brief Consume un paso de lógica pendiente.
+ *
+ * @return 1 si hay que ejecutar otro paso de lógica, 0 si no.
+ */
+int pacer_step();
+
+/**
+ * @brief Duración de un paso de lógica en segundos.
+ */
+float pacer_step_seconds();
+
+/**
+ * @brief Fracción del siguiente paso ya transcurrida (0 a 1).
+ *
+ * Sirve para interpolar entre el estado anterior y el actual al dibujar.
+ */
+float pacer_alpha();
+
+/**
+ * @brief Espera hasta el siguiente instante de presentación.
+ *
+ * Duerme hasta poco antes del plazo y termina con espera activa, así el
+ * error no depende de la granularidad de `SDL_Delay`. Los plazos avanzan un
+ * periodo exacto cada frame, sin deriva; si el frame llega tarde por más de
+ * un periodo el plazo se reinicia en lugar de encadenar frames sin espera.
+ */
+void pacer_wait();
+
+/**
+ * @brief Obtiene las estadísticas de los últimos frames.
+ */
+void pacer_get_stats(pacer_stats *out);
+
+/**
+ * @brief Vacía el histograma y los contadores.
+ */
+void pacer_reset_stats();
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
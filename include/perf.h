@@ -0,0 +1,161 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef PERF_H_
+#define PERF_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+#include <pacer.h>
+
+
+/**
+ * @brief Activa los contadores, los temporizadores y el panel.
+ *
+ * Desactivado por defecto: las macros `PERF_*` no generan código, `Render()`
+ * no dibuja el panel y las consultas devuelven 0. Para medir se compila todo
+ * con `-DPERF_ENABLED=1` en `CFLAGS` y `CXXFLAGS`.
+ */
+#ifndef PERF_ENABLED
+#define PERF_ENABLED 0
+#endif
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @brief Contadores por frame. Los terminados en `_NS` son tiempos en
+ *        nanosegundos.
+ */
+enum {
+	PERF_BLITS,			///< Copias de superficies (sprites, texturas, colas).
+	PERF_PIXELS,		///< Píxeles escritos por copias y rellenos.
+	PERF_SURFACES,		///< Superficies creadas.
+	PERF_ROTOZOOMS,		///< Rotaciones/escalados calculados.
+	PERF_GLYPHS,		///< Caracteres dibujados (fuente incorporada y SFont).
+	PERF_FRAME_NS,		///< Tiempo entre dos `Render()`.
+	PERF_PRESENT_NS,	///< Presentación dentro de `Render()`.
+	PERF_DEFERRED_NS,	///< `deferred_end()`.
+	PERF_QUEUE_NS,		///< `render_queue_end()`.
+	PERF_AUDIO_NS,		///< Callback de audio.
+	PERF_COUNTERS
+};
+
+/**
+ * @brief Valores del frame en curso; usar las macros para modificarlos.
+ *
+ * Cada contador se toca desde un solo hilo (el callback de audio solo toca
+ * `PERF_AUDIO_NS`), así que no se usan operaciones atómicas: como mucho se
+ * pierde una suma de audio al cerrar el frame.
+ */
+extern Uint64 perf_counters[PERF_COUNTERS];
+
+
+#if PERF_ENABLED
+#define PERF_COUNT(id, n)		(perf_counters[id] += (Uint64)(n))
+/** @brief Declara el inicio de una medida; va entre las declaraciones. */
+#define PERF_TIMER_BEGIN(id)	Uint64 perf_t0_##id = pacer_now_ns()
+#define PERF_TIMER_END(id)		PERF_COUNT(id, pacer_now_ns() - perf_t0_##id)
+#define PERF_FRAME()			perf_frame()
+#else
+#define PERF_COUNT(id, n)		((void)0)
+#define PERF_TIMER_BEGIN(id)	int perf_t0_##id = 0
+#define PERF_TIMER_END(id)		((void)perf_t0_##id)
+#define PERF_FRAME()			((void)0)
+#endif
+
+
+/**
+ * @brief Cierra el frame: guarda los contadores y los pone a cero.
+ *
+ * Lo llama `Render()` a través de `PERF_FRAME()`.
+ */
+void perf_frame();
+
+/**
+ * @brief Valor de un contador en el último frame cerrado.
+ */
+Uint64 perf_get(int id);
+
+/**
+ * @brief Valor máximo de un contador desde `perf_reset()`.
+ */
+Uint64 perf_get_max(int id);
+
+/**
+ * @brief Frames cerrados desde `perf_reset()`.
+ */
+int perf_frames();
+
+/**
+ * @brief Borra los máximos y el frame en curso.
+ */
+void perf_reset();
+
+/**
+ * @brief Nombre corto de un contador, para informes.
+ */
+const char *perf_name(int id);
+
+
+/**
+ * @brief Muestra u oculta el panel que `Render()` dibuja sobre `vram`.
+ */
+void perf_show_hud(int enable);
+
+/**
+ * @brief Indica si el panel está visible.
+ */
+int perf_hud_visible();
+
+/**
+ * @brief Texto de una línea del panel, o NULL después de la última.
+ *
+ * Sirve para dibujar el panel con otra fuente (por ejemplo `gfxFont::draw`).
+ * El texto es válido hasta la siguiente llamada.
+ */
+const char *perf_hud_line(int line);
+
+/**
+ * @brief Dibuja el panel en `vram` con la fuente incorporada (`print_f`).
+ */
+void perf_draw_hud(int x, int y);
+
+
+
+#ifdef __cplusplus
+}
+
+#if PERF_ENABLED
+/**
+ * @brief Temporizador de ámbito: suma el tiempo de vida del objeto a `id`.
+ */
+struct perf_scope {
+	int id;
+	Uint64 t0;
+
+	explicit perf_scope(int i) : id(i), t0(pacer_now_ns()) {}
+	~perf_scope() { perf_counters[id] += pacer_now_ns() - t0; }
+};
+
+#define PERF_CAT2(a, b) a##b
+#define PERF_CAT(a, b) PERF_CAT2(a, b)
+#define PERF_SCOPE(id) perf_scope PERF_CAT(perf_scope_, __LINE__)(id)
+#else
+#define PERF_SCOPE(id) ((void)0)
+#endif
+
+#endif
+
+#endif
@@ -34,6 +34,8 @@ extern "C" {
  * @param c Color del píxel a dibujar (valor de 32 bits en formato de la superficie).
  *
  * @note La función no realiza ninguna comprobación de límites de los valores `x` y `y`. Si las coordenadas están fuera de los límites de la superficie, el comportamiento será indefinido.
+ * @note No registra la zona sucia: quien dibuje en `vram` píxel a píxel debe marcar la
+ *       zona completa con `dirty_rect_add`.
  */
 void pixel(SDL_Surface *src, int x, int y, u32 c);
 
@@ -0,0 +1,176 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef PIXFMT_H_
+#define PIXFMT_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @name Tipos de formato
+ * @{
+ */
+#define PIXFMT_GENERIC	0	///< Color directo cualquiera: tablas por canal.
+#define PIXFMT_ARGB8888	1	///< 32 bits con R en 0xFF0000, G en 0xFF00 y B en 0xFF.
+#define PIXFMT_RGB565	2	///< 16 bits con R en 0xF800, G en 0x07E0 y B en 0x1F.
+#define PIXFMT_PALETTE	3	///< Con paleta: se delega en SDL.
+/** @} */
+
+
+/**
+ * @brief Descriptor de un formato de píxel.
+ *
+ * Da los mismos valores que `SDL_MapRGB`/`SDL_GetRGB` (incluido el canal
+ * alpha opaco al empaquetar) sin la llamada ni la lectura del formato por
+ * píxel. Los formatos comunes se resuelven con desplazamientos fijos; el
+ * resto con una tabla por canal de 256 entradas.
+ */
+typedef struct {
+	int kind;					///< `PIXFMT_*`.
+	int bpp;					///< Bytes por píxel.
+	u32 rmask, gmask, bmask, amask;
+	u8 rshift, gshift, bshift;
+	u32 pack[3][256];			///< Valor de 0-255 ya colocado en el canal (genérico).
+	u8 expand[3][256];			///< Campo del píxel a 0-255 (genérico).
+	SDL_PixelFormat *format;	///< Formato original, para `PIXFMT_PALETTE`.
+} pixfmt;
+
+
+/**
+ * @brief Rellena `pf` a partir de un formato de SDL.
+ *
+ * Solo el tipo genérico construye tablas; para los demás es inmediato.
+ */
+void pixfmt_init(pixfmt *pf, SDL_PixelFormat *fmt);
+
+/**
+ * @brief Descriptor de `vram`, calculado en `Set_Video()`.
+ *
+ * @return NULL antes de abrir el video.
+ */
+const pixfmt *pixfmt_video();
+
+/**
+ * @brief Vuelve a calcular el descriptor de `vram` (lo llama `Set_Video()`).
+ */
+void pixfmt_video_update(SDL_PixelFormat *fmt);
+
+/**
+ * @brief Descriptor para `fmt` sin estado compartido.
+ *
+ * Si `fmt` tiene el mismo formato que `vram` devuelve el descriptor de
+ * video; si no, rellena `scratch` y lo devuelve. Se puede llamar desde
+ * varios hilos.
+ */
+const pixfmt *pixfmt_get(SDL_PixelFormat *fmt, pixfmt *scratch);
+
+
+/** @brief Empaqueta RGB en ARGB8888 (alpha opaco si `amask`). */
+static inline u32 pixfmt_pack_argb8888(u32 amask, u8 r, u8 g, u8 b){
+	return amask | ((u32)r << 16) | ((u32)g << 8) | b;
+}
+
+/** @brief Empaqueta RGB en RGB565. */
+static inline u32 pixfmt_pack_rgb565(u8 r, u8 g, u8 b){
+	return ((u32)(r >> 3) << 11) | ((u32)(g >> 2) << 5) | (b >> 3);
+}
+
+/** @brief Desempaqueta ARGB8888. */
+static inline void pixfmt_unpack_argb8888(u32 p, u8 *r, u8 *g, u8 *b){
+	*r = (u8)(p >> 16);
+	*g = (u8)(p >> 8);
+	*b = (u8)p;
+}
+
+/**
+ * @brief Desempaqueta RGB565 replicando los bits altos en los bajos, como
+ *        `SDL_GetRGB` (0x1F pasa a 0xFF).
+ */
+static inline void pixfmt_unpack_rgb565(u32 p, u8 *r, u8 *g, u8 *b){
+	u32 r5 = (p >> 11) & 0x1f, g6 = (p >> 5) & 0x3f, b5 = p & 0x1f;
+
+	*r = (u8)((r5 << 3) | (r5 >> 2));
+	*g = (u8)((g6 << 2) | (g6 >> 4));
+	*b = (u8)((b5 << 3) | (b5 >> 2));
+}
+
+/**
+ * @brief Equivalente a `SDL_MapRGB` con el descriptor.
+ *
+ * En bucles conviene sacar el `switch` fuera y llamar directamente a la
+ * variante del tipo.
+ */
+static inline u32 pixfmt_pack(const pixfmt *pf, u8 r, u8 g, u8 b){
+	switch (pf->kind) {
+	case PIXFMT_ARGB8888:
+		return pixfmt_pack_argb8888(pf->amask, r, g, b);
+	case PIXFMT_RGB565:
+		return pixfmt_pack_rgb565(r, g, b);
+	case PIXFMT_GENERIC:
+		return pf->pack[0][r] | pf->pack[1][g] | pf->pack[2][b] | pf->amask;
+	default:
+		return SDL_MapRGB(pf->format, r, g, b);
+	}
+}
+
+/**
+ * @brief Equivalente a `SDL_GetRGB` con el descriptor.
+ */
+static inline void pixfmt_unpack(const pixfmt *pf, u32 p, u8 *r, u8 *g, u8 *b){
+	switch (pf->kind) {
+	case PIXFMT_ARGB8888:
+		pixfmt_unpack_argb8888(p, r, g, b);
+		break;
+	case PIXFMT_RGB565:
+		pixfmt_unpack_rgb565(p, r, g, b);
+		break;
+	case PIXFMT_GENERIC:
+		*r = pf->expand[0][(p & pf->rmask) >> pf->rshift];
+		*g = pf->expand[1][(p & pf->gmask) >> pf->gshift];
+		*b = pf->expand[2][(p & pf->bmask) >> pf->bshift];
+		break;
+	default:
+		SDL_GetRGB(p, pf->format, r, g, b);
+		break;
+	}
+}
+
+/**
+ * @brief Empaqueta un color 0xRRGGBB.
+ */
+static inline u32 pixfmt_pack_rgb(const pixfmt *pf, u32 rgb){
+	return pixfmt_pack(pf, (u8)(rgb >> 16), (u8)(rgb >> 8), (u8)rgb);
+}
+
+/**
+ * @brief Desempaqueta a un color 0xRRGGBB.
+ */
+static inline u32 pixfmt_unpack_rgb(const pixfmt *pf, u32 p){
+	u8 r, g, b;
+
+	pixfmt_unpack(pf, p, &r, &g, &b);
+	return ((u32)r << 16) | ((u32)g << 8) | b;
+}
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef PRESENT_H_
+#define PRESENT_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @name Opciones de escalado
+ * @{
+ */
+#define PRESENT_NEAREST		0x00	///< Vecino más cercano (bloques de NxN).
+#define PRESENT_EPX			0x01	///< Scale2x/EPX: suaviza diagonales sin mezclar colores.
+#define PRESENT_SCANLINES	0x02	///< Oscurece la última fila de cada bloque.
+/** @} */
+
+/**
+ * @brief Factor de escalado máximo admitido.
+ */
+#define PRESENT_MAX_SCALE 4
+
+
+/**
+ * @brief Escala una zona de `src` a `dst` con un factor entero.
+ *
+ * Los núcleos de 2x, 3x y 4x están especializados con SSE2 (y NEON para 2x
+ * y 4x); cada fila se genera una vez y se copia a las demás filas del
+ * bloque. `PRESENT_EPX` se aplica a 2x; a 4x se aplica EPX y después un 2x
+ * por vecino más cercano, y a 3x se usa vecino más cercano.
+ *
+ * Los vecinos de EPX se leen fuera de `rect` cuando hace falta, así que
+ * escalar solo las zonas sucias da el mismo resultado que la pantalla entera
+ * siempre que la zona se amplíe un píxel por cada lado.
+ *
+ * @param src Superficie de 32 bits con la imagen original.
+ * @param dst Superficie de 32 bits, del mismo formato y al menos `scale`
+ *            veces más grande.
+ * @param rect Zona de `src` a escalar, o NULL para toda la superficie.
+ * @param scale Factor de 1 a `PRESENT_MAX_SCALE`.
+ * @param flags Combinación de `PRESENT_*`.
+ * @return 0 si se escaló, -1 si las superficies no son compatibles.
+ */
+int present_scale(SDL_Surface *src, SDL_Surface *dst, const SDL_Rect *rect, int scale, int flags);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
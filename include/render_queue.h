@@ -0,0 +1,222 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <SDL/SDL.h>
+#include <types.h>
+#include <SFont.h>
+
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+/**
+ * @name Clave de orden de 64 bits
+ *
+ * De mayor a menor peso: capa (8 bits), tramo de la capa (12), modo de
+ * mezcla (2), alpha (8), superficie origen (18) y profundidad (16). Las
+ * órdenes con la misma clave conservan el orden de llamada. La superficie se
+ * guarda como un número asignado por orden de aparición en el frame, así que
+ * dentro de un tramo las hojas se dibujan en el orden en que se usaron por
+ * primera vez.
+ *
+ * Las órdenes sin superficie (rellenos, primitivas, textos de la fuente
+ * incorporada y llamadas) cierran el tramo de su capa: todo lo grabado antes
+ * en la capa se dibuja debajo y todo lo posterior encima, así que una caja
+ * pintada sobre un sprite queda encima. Los blits solo se agrupan por
+ * superficie entre dos de estas órdenes. Pasados 4095 tramos en una capa el
+ * resto comparte el último y vuelve a ordenarse por superficie. La
+ * profundidad de estas órdenes se ignora.
+ * @{
+ */
+#define RENDER_KEY_LAYER_SHIFT		56
+#define RENDER_KEY_SEGMENT_SHIFT	44
+#define RENDER_KEY_BLEND_SHIFT		42
+#define RENDER_KEY_ALPHA_SHIFT		34
+#define RENDER_KEY_SOURCE_SHIFT		16
+#define RENDER_KEY_SEGMENT_MAX		0xfff
+#define RENDER_KEY_SOURCE_MAX		0x3ffff
+/** @} */
+
+/**
+ * @name Modos de mezcla
+ * @{
+ */
+#define RENDER_BLEND_NONE	0	///< La superficie tal como esté configurada (color key, RLE...).
+#define RENDER_BLEND_ALPHA	1	///< Alpha por superficie con el valor de la orden.
+/** @} */
+
+
+/**
+ * @brief Descarte propio: devuelve 0 para no dibujar una orden.
+ *
+ * @param bounds Caja de la orden en el destino, ya recortada.
+ * @param ctx Contexto pasado a `render_queue_set_cull`.
+ */
+typedef int (*render_cull_func)(const SDL_Rect *bounds, void *ctx);
+
+/**
+ * @brief Orden de dibujo personalizada.
+ *
+ * @param dst Superficie destino.
+ * @param ctx Contexto pasado a `render_queue_call`.
+ */
+typedef void (*render_call_func)(SDL_Surface *dst, void *ctx);
+
+/**
+ * @brief Contadores del último `render_queue_end`.
+ */
+typedef struct {
+	int commands;		///< Órdenes grabadas.
+	int culled;			///< Órdenes descartadas al grabar.
+	int drawn;			///< Órdenes dibujadas.
+	int runs;			///< Tramos con la misma superficie y mezcla.
+	int sort_passes;	///< Pasadas del radix sort (bytes de clave que variaban).
+} render_queue_stats;
+
+
+/**
+ * @brief Empieza un frame de órdenes para `dst`.
+ *
+ * Las órdenes fuera del área de recorte de `dst` (o rechazadas por el
+ * descarte propio) se tiran al grabarlas. En `render_queue_end` se ordenan
+ * por clave con un radix sort y se ejecutan por tramos que comparten
+ * superficie y mezcla: el alpha se configura una vez por tramo y los blits
+ * van ya recortados a `SDL_LowerBlit`.
+ *
+ * Mientras se graba, `Sprite::draw`, `GfxTexture::render`, `print` y
+ * `SFont_Write` sobre `dst` se graban en la capa de
+ * `render_queue_set_layer` con profundidad 0 en vez de dibujar. Las
+ * superficies grabadas se retienen hasta `render_queue_end`, así que se
+ * pueden liberar antes.
+ *
+ * @return 0 si se pudo empezar, -1 si `dst` no es válida.
+ */
+int render_queue_begin(SDL_Surface *dst);
+
+/**
+ * @brief Destino del frame en curso, o NULL si no se está grabando.
+ */
+SDL_Surface *render_queue_target();
+
+/**
+ * @brief Capa (0 a 255) de los dibujos redirigidos a la cola. Por defecto 0.
+ */
+void render_queue_set_layer(int layer);
+
+/**
+ * @brief Capa fijada con `render_queue_set_layer`.
+ */
+int render_queue_layer();
+
+/**
+ * @brief Instala el descarte propio (NULL lo quita).
+ */
+void render_queue_set_cull(render_cull_func fn, void *ctx);
+
+/**
+ * @brief Graba una copia de `src`.
+ *
+ * @param src Superficie origen.
+ * @param srect Zona de `src`, o NULL para toda la superficie.
+ * @param x Posición X en el destino.
+ * @param y Posición Y en el destino.
+ * @param layer Capa de 0 a 255; las menores se dibujan antes.
+ * @param depth Profundidad de 0 a 65535 dentro de la misma superficie.
+ */
+void render_queue_blit(SDL_Surface *src, const SDL_Rect *srect, int x, int y, int layer, int depth);
+
+/**
+ * @brief Como `render_queue_blit` con alpha por superficie.
+ *
+ * Con `alpha` 255 equivale a `render_queue_blit`.
+ */
+void render_queue_blit_alpha(SDL_Surface *src, const SDL_Rect *srect, int x, int y,
+		Uint8 alpha, int layer, int depth);
+
+/**
+ * @brief Graba un texto con SFont; se agrupa con los blits de su hoja.
+ */
+void render_queue_sfont(const SFont_Font *font, int x, int y, const char *text, int layer, int depth);
+
+/**
+ * @brief Graba un texto con la fuente incorporada, con el tamaño de celda
+ *        actual de `fontsize()`.
+ */
+void render_queue_text(int x, int y, const char *text, u32 color, int layer, int depth);
+
+/**
+ * @brief Graba el relleno de un rectángulo con `fill_rect`.
+ *
+ * @param color Color ya convertido al formato del destino.
+ */
+void render_queue_fill(const SDL_Rect *rect, u32 color, int layer, int depth);
+
+/**
+ * @name Primitivas de SDL_gfx (color en formato 0xRRGGBBAA)
+ * @{
+ */
+void render_queue_line(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth);
+void render_queue_rect(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth);
+void render_queue_box(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth);
+void render_queue_circle(int x, int y, int r, u32 rgba, int layer, int depth);
+void render_queue_filled_circle(int x, int y, int r, u32 rgba, int layer, int depth);
+/** @} */
+
+/**
+ * @brief Graba una orden personalizada.
+ *
+ * @param bounds Zona que puede modificar, para el descarte y las zonas
+ *               sucias (NULL: todo el destino).
+ */
+void render_queue_call(render_call_func fn, void *ctx, const SDL_Rect *bounds, int layer, int depth);
+
+/**
+ * @brief Retiene `s` hasta `render_queue_end` (para superficies que usa una
+ *        orden personalizada).
+ *
+ * @return 0, o -1 si no se está grabando o no hay memoria.
+ */
+int render_queue_keep(SDL_Surface *s);
+
+/**
+ * @brief Reserva memoria para el contexto de una orden personalizada; se
+ *        reutiliza tras `render_queue_end`.
+ *
+ * @return NULL si no se está grabando, `size` pasa de 16 KB o no hay memoria.
+ */
+void *render_queue_alloc(int size);
+
+/**
+ * @brief Ordena y dibuja las órdenes del frame y vacía la cola.
+ *
+ * Las zonas dibujadas se registran como sucias aquí, una vez por orden.
+ *
+ * @return Número de órdenes dibujadas.
+ */
+int render_queue_end();
+
+/**
+ * @brief Copia los contadores del último frame en `out`.
+ */
+void render_queue_get_stats(render_queue_stats *out);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,6 +13,7 @@
 
 #include <SDL/SDL.h>
 #include <types.h>
+#include <present.h>
 
 
 #ifdef __cplusplus
@@ -47,6 +48,21 @@ extern SDL_Surface *vram;
  */
 extern u32 *fb;
 
+/**
+ * @name Opciones de video sin pantalla
+ *
+ * Se combinan con OR y se pasan a `video_set_flags()` antes de
+ * `Init_Sistem()`, o en la variable de entorno `GPP_HEADLESS` (como número)
+ * para activarlas sin recompilar. Cualquier valor distinto de 0 en la
+ * variable implica `VIDEO_HEADLESS`.
+ * @{
+ */
+#define VIDEO_HEADLESS	0x01	///< `vram` es una superficie en memoria, sin ventana.
+#define VIDEO_HASH		0x02	///< `Render()` calcula un hash del frame.
+#define VIDEO_DUMP		0x04	///< `Render()` guarda cada frame como BMP.
+#define VIDEO_UNPACED	0x08	///< Sin espera entre frames: corre a máxima velocidad.
+/** @} */
+
 
 
 /**
@@ -70,6 +86,44 @@ extern u32 *fb;
  */
 int Init_Sistem(const char *msg);
 
+/**
+ * @brief Selecciona el modo de video sin pantalla y sus opciones.
+ *
+ * En modo sin pantalla SDL usa su driver `dummy`: `Set_Video()` crea `vram`
+ * como superficie de software, los eventos siguen funcionando y `Render()`
+ * no presenta nada; según las opciones calcula un hash del frame o lo vuelca
+ * a disco. Sirve para medir el rendimiento de escenas reales y comparar su
+ * salida en servidores sin pantalla.
+ *
+ * @param flags Combinación de `VIDEO_*`. Debe llamarse antes de `Init_Sistem()`.
+ */
+void video_set_flags(int flags);
+
+/**
+ * @brief Devuelve las opciones de video activas (`VIDEO_*`).
+ */
+int video_flags();
+
+/**
+ * @brief Patrón `printf` de los archivos de `VIDEO_DUMP`.
+ *
+ * Recibe el número de frame; por defecto `"frame_%05u.bmp"`.
+ */
+void video_set_dump_pattern(const char *pattern);
+
+/**
+ * @brief Hash FNV-1a de 64 bits del último frame (con `VIDEO_HASH`).
+ *
+ * Solo se hashean los canales de color visibles, así el resultado no depende
+ * del pitch ni del byte de relleno de las superficies de 32 bits.
+ */
+Uint64 video_frame_hash();
+
+/**
+ * @brief Número de frames presentados con `Render()` desde `Set_Video()`.
+ */
+Uint32 video_frame_count();
+
 /**
  * @brief Configura la resolución de video.
  *
@@ -91,6 +145,23 @@ int Init_Sistem(const char *msg);
 int Set_Video(int width, int height);
 
 
+/**
+ * @brief Configura el video con un búfer interno escalado a la ventana.
+ *
+ * La ventana se abre a `width * scale` x `height * scale`, pero `vram` (y
+ * `fb`) siguen siendo de `width` x `height`: el juego dibuja a la resolución
+ * original y `Render()` escala el frame con `present_scale()`. Con las
+ * regiones sucias activas solo se escalan las zonas modificadas.
+ *
+ * @param width Ancho interno en píxeles (p. ej. 320).
+ * @param height Alto interno en píxeles (p. ej. 240).
+ * @param scale Factor entero de 1 a `PRESENT_MAX_SCALE`; 1 equivale a `Set_Video()`.
+ * @param flags Combinación de `PRESENT_*` (EPX, scanlines).
+ *
+ * @return 0 si se configuró el modo, o -1 si hubo algún error.
+ */
+int Set_Video_Scaled(int width, int height, int scale, int flags);
+
 /**
  * @brief Obtiene las dimensiones de la resolución de video actual.
  *
@@ -141,6 +212,15 @@ void off_video();
  * @note Asegúrese de que todos los objetos gráficos y recursos hayan sido preparados
  *       antes de llamar a esta función. Esta función puede implicar una actualización
  *       de la superficie de video o del framebuffer.
+ *
+ * @note También avanza las animaciones de los sprites que llamaron a
+ *       `animate()` en este frame, con `anim_update()`.
+ *
+ * @note En modo `VIDEO_HEADLESS` no presenta nada: calcula el hash o vuelca
+ *       el frame según las opciones de `video_set_flags()`.
+ *
+ * @note Con `PERF_ENABLED` cierra el frame de los contadores de `perf.h` y,
+ *       si está activo, dibuja antes el panel de `perf_show_hud()`.
  */
 void Render();
 
@@ -190,6 +270,14 @@ void cls_rgb(u8 r, u8 g, u8 b);
  */
 u32 color_rgb(u8 r, u8 g, u8 b);
 
+/**
+ * @brief Espera hasta completar un frame de `frecuencia` milisegundos.
+ *
+ * Usa el planificador de `pacer.h` (reloj en nanosegundos, espera híbrida y
+ * plazos sin deriva), por lo que sus tiempos aparecen en `pacer_get_stats()`.
+ *
+ * @param frecuencia Duración del frame en milisegundos (20 = 50 FPS).
+ */
 void Fps_sincronizar(int frecuencia);
 
 
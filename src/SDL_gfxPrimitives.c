@@ -13,6 +13,7 @@
 
 #include "SDL_gfxPrimitives.h"
 #include "SDL_gfxPrimitives_font.h"
+#include "dirty_rect.h"
 
 /* -===================- */
 
@@ -115,6 +116,11 @@ int fastPixelColor(SDL_Surface * dst, Sint16 x, Sint16 y, Uint32 color)
 {
     int result;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_xywh(dst, x, y, 1, 1);
+
     /*
      * Lock the surface 
      */
@@ -298,6 +304,11 @@ int pixelColor(SDL_Surface * dst, Sint16 x, Sint16 y, Uint32 color)
     Uint32 mcolor;
     int result = 0;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_xywh(dst, x, y, 1, 1);
+
     /*
      * Lock the surface 
      */
@@ -336,6 +347,11 @@ int pixelColorNolock(SDL_Surface * dst, Sint16 x, Sint16 y, Uint32 color)
     Uint32 mcolor;
     int result = 0;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_xywh(dst, x, y, 1, 1);
+
     /*
      * Setup color 
      */
@@ -612,6 +628,11 @@ int hlineColorStore(SDL_Surface * dst, Sint16 x1, Sint16 x2, Sint16 y, Uint32 co
     Sint16 xtmp;
     int result = -1;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x1, y, x2, y);
+
     /*
      * Get clipping boundary 
      */
@@ -745,6 +766,11 @@ int hlineColor(SDL_Surface * dst, Sint16 x1, Sint16 x2, Sint16 y, Uint32 color)
     int result = -1;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x1, y, x2, y);
+
     /*
      * Get clipping boundary 
      */
@@ -909,6 +935,11 @@ int vlineColor(SDL_Surface * dst, Sint16 x, Sint16 y1, Sint16 y2, Uint32 color)
     int result = -1;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x, y1, x, y2);
+
     /*
      * Get clipping boundary 
      */
@@ -1244,6 +1275,11 @@ int boxColor(SDL_Surface * dst, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint
     int result;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x1, y1, x2, y2);
+
     /*
      * Get clipping boundary 
      */
@@ -1447,6 +1483,11 @@ int lineColor(SDL_Surface * dst, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uin
     Uint8 *pixel;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x1, y1, x2, y2);
+
     /*
      * Clip line and test if we have to draw 
      */
@@ -1660,6 +1701,12 @@ int aalineColorInt(SDL_Surface * dst, Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2
     Uint32 erracctmp, wgt, wgtcompmask;
     int dx, dy, tmp, xdir, y0p1, x0pxdir;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_xywh(dst, ((x1 < x2) ? x1 : x2) - 1, ((y1 < y2) ? y1 : y2) - 1,
+			abs(x2 - x1) + 3, abs(y2 - y1) + 3);
+
     /*
      * Clip line and test if we have to draw 
      */
@@ -1886,6 +1933,11 @@ int circleColor(SDL_Surface * dst, Sint16 x, Sint16 y, Sint16 r, Uint32 color)
     Sint16 ypcy, ymcy, ypcx, ymcx;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x - r, y - r, x + r, y + r);
+
     /*
      * Sanity check radius 
      */
@@ -2250,6 +2302,11 @@ int ellipseColor(SDL_Surface * dst, Sint16 x, Sint16 y, Sint16 rx, Sint16 ry, Ui
     int xmk, xpk, ymh, yph;
     Uint8 *colorptr;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, x - rx, y - ry, x + rx, y + ry);
+
     /*
      * Sanity check radii 
      */
@@ -2554,6 +2611,11 @@ int aaellipseColor(SDL_Surface * dst, Sint16 xc, Sint16 yc, Sint16 rx, Sint16 ry
     Uint8 weight, iweight;
     int result;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_bounds(dst, xc - rx - 1, yc - ry - 1, xc + rx + 1, yc + ry + 1);
+
     /*
      * Sanity check radii 
      */
@@ -3444,6 +3506,11 @@ int characterColor(SDL_Surface * dst, Sint16 x, Sint16 y, char c, Uint32 color)
     int forced_redraw;
     Uint8 patt, mask;
 
+    /*
+     * Record modified region 
+     */
+    dirty_rect_add_xywh(dst, x, y, charWidth, charHeight);
+
     /*
      * Get clipping boundary 
      */
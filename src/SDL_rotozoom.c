@@ -14,76 +14,278 @@
 #include <string.h>
 
 #include "SDL_rotozoom.h"
+#include "job_pool.h"
 
 #define MAX(a,b)    (((a) > (b)) ? (a) : (b))
+#define MIN(a,b)    (((a) < (b)) ? (a) : (b))
 
 /* 
  
- 32bit Zoomer with optional anti-aliasing by bilinear interpolation.
+ Bilinear interpolation kernels.
 
- Zoomes 32bit RGBA/ABGR 'src' surface to 'dst' surface.
+ The smoothing paths collect up to RZ_BATCH pixels (their four neighbours and
+ the 16bit fractions ex/ey) and filter them in one go. The SIMD kernels use the
+ same integer formula as the scalar one, so every path produces the same bytes:
+
+   t1 = (((c01 - c00) * ex) >> 16) + c00
+   t2 = (((c11 - c10) * ex) >> 16) + c10
+   c  = (((t2 - t1) * ey) >> 16) + t1
+
+ Both terms always stay within 0..255, which lets the SIMD code work on 16bit
+ lanes.
  
 */
 
-int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, int smooth)
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RZ_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RZ_NEON
+#endif
+
+#define RZ_BATCH 8
+
+typedef struct tBilinearBatch {
+    tColorRGBA c00[RZ_BATCH], c01[RZ_BATCH], c10[RZ_BATCH], c11[RZ_BATCH];
+    tColorRGBA out[RZ_BATCH];
+    int ex[RZ_BATCH], ey[RZ_BATCH];
+    tColorRGBA *dp[RZ_BATCH];
+    int n;
+    int simd;
+} tBilinearBatch;
+
+/* -1: not checked yet, 0: scalar, 1: SIMD */
+static int rzSIMD = -1;
+
+static int detectSIMD(void)
 {
-    int x, y, sx, sy, *sax, *say, *csax, *csay, csx, csy, ex, ey, t1, t2, sstep;
-    tColorRGBA *c00, *c01, *c10, *c11;
-    tColorRGBA *sp, *csp, *dp;
-    int dgap;
+#if defined(RZ_SSE2)
+    return SDL_HasSSE2() ? 1 : 0;
+#elif defined(RZ_NEON)
+    return 1;
+#else
+    return 0;
+#endif
+}
 
-    /*
-     * Variable setup 
-     */
-    if (smooth) {
+void rotozoomUseSIMD(int enable)
+{
+    rzSIMD = enable ? detectSIMD() : 0;
+}
+
+static int useSIMD(void)
+{
+    if (rzSIMD < 0) {
+	rzSIMD = detectSIMD();
+    }
+    return rzSIMD;
+}
+
+static void interpolateRGBA_C(tBilinearBatch * b, int first)
+{
+    int i, t1, t2, ex, ey;
+    tColorRGBA *c00, *c01, *c10, *c11, *dp;
+
+    for (i = first; i < b->n; i++) {
+	c00 = &b->c00[i];
+	c01 = &b->c01[i];
+	c10 = &b->c10[i];
+	c11 = &b->c11[i];
+	dp = &b->out[i];
+	ex = b->ex[i];
+	ey = b->ey[i];
+	t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
+	t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
+	dp->r = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
+	t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
+	dp->g = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
+	t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
+	dp->b = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
+	t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
+	dp->a = (((t2 - t1) * ey) >> 16) + t1;
+    }
+}
+
+#if defined(RZ_SSE2)
+
+/*
+ * a + ((b - a) * f >> 16) on 8 lanes, with a signed difference and an unsigned
+ * 16bit fraction. The unsigned high multiply is corrected by f for negative
+ * differences, which gives the same floor() as the 32bit scalar shift.
+ */
+static __m128i lerpEpi16SSE2(__m128i a, __m128i b, __m128i f)
+{
+    __m128i d, h;
+
+    d = _mm_sub_epi16(b, a);
+    h = _mm_mulhi_epu16(d, f);
+    h = _mm_sub_epi16(h, _mm_and_si128(_mm_srai_epi16(d, 15), f));
+    return _mm_add_epi16(h, a);
+}
+
+static void interpolateRGBA_SIMD(tBilinearBatch * b)
+{
+    __m128i zero, c00, c01, c10, c11, fx, fy, t1, t2;
+    int i;
+
+    zero = _mm_setzero_si128();
+    for (i = 0; i + 2 <= b->n; i += 2) {
 	/*
-	 * For interpolation: assume source dimension is one pixel 
+	 * Two pixels per register: 8 lanes of r,g,b,a 
 	 */
+	c00 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) & b->c00[i]), zero);
+	c01 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) & b->c01[i]), zero);
+	c10 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) & b->c10[i]), zero);
+	c11 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *) & b->c11[i]), zero);
+	fx = _mm_set_epi16((short) b->ex[i + 1], (short) b->ex[i + 1], (short) b->ex[i + 1], (short) b->ex[i + 1],
+			   (short) b->ex[i], (short) b->ex[i], (short) b->ex[i], (short) b->ex[i]);
+	fy = _mm_set_epi16((short) b->ey[i + 1], (short) b->ey[i + 1], (short) b->ey[i + 1], (short) b->ey[i + 1],
+			   (short) b->ey[i], (short) b->ey[i], (short) b->ey[i], (short) b->ey[i]);
+	t1 = lerpEpi16SSE2(c00, c01, fx);
+	t2 = lerpEpi16SSE2(c10, c11, fx);
+	t1 = lerpEpi16SSE2(t1, t2, fy);
+	_mm_storel_epi64((__m128i *) & b->out[i], _mm_packus_epi16(t1, zero));
+    }
+    interpolateRGBA_C(b, i);
+}
+
+#elif defined(RZ_NEON)
+
+/*
+ * a + ((b - a) * f >> 16) on 8 lanes. The products are widened to 32bit so the
+ * shift is the same as in the scalar code.
+ */
+static int16x8_t lerpS16NEON(int16x8_t a, int16x8_t b, uint16x8_t f)
+{
+    int16x8_t d;
+    int32x4_t lo, hi;
+
+    d = vsubq_s16(b, a);
+    lo = vmulq_s32(vmovl_s16(vget_low_s16(d)), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(f))));
+    hi = vmulq_s32(vmovl_s16(vget_high_s16(d)), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(f))));
+    return vaddq_s16(a, vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+}
+
+static void interpolateRGBA_SIMD(tBilinearBatch * b)
+{
+    int16x8_t c00, c01, c10, c11, t1, t2;
+    uint16x8_t fx, fy;
+    int i;
+
+    for (i = 0; i + 2 <= b->n; i += 2) {
 	/*
-	 * smaller to avoid overflow on right and bottom edge.     
+	 * Two pixels per register: 8 lanes of r,g,b,a 
 	 */
-	sx = (int) (65536.0 * (float) (src->w - 1) / (float) dst->w);
-	sy = (int) (65536.0 * (float) (src->h - 1) / (float) dst->h);
-    } else {
-	sx = (int) (65536.0 * (float) src->w / (float) dst->w);
-	sy = (int) (65536.0 * (float) src->h / (float) dst->h);
+	c00 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8((const uint8_t *) &b->c00[i])));
+	c01 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8((const uint8_t *) &b->c01[i])));
+	c10 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8((const uint8_t *) &b->c10[i])));
+	c11 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8((const uint8_t *) &b->c11[i])));
+	fx = vcombine_u16(vdup_n_u16((uint16_t) b->ex[i]), vdup_n_u16((uint16_t) b->ex[i + 1]));
+	fy = vcombine_u16(vdup_n_u16((uint16_t) b->ey[i]), vdup_n_u16((uint16_t) b->ey[i + 1]));
+	t1 = lerpS16NEON(c00, c01, fx);
+	t2 = lerpS16NEON(c10, c11, fx);
+	t1 = lerpS16NEON(t1, t2, fy);
+	vst1_u8((uint8_t *) &b->out[i], vmovn_u16(vreinterpretq_u16_s16(t1)));
     }
+    interpolateRGBA_C(b, i);
+}
 
-    /*
-     * Allocate memory for row increments 
-     */
-    if ((sax = (int *) malloc((dst->w + 1) * sizeof(Uint32))) == NULL) {
-	return (-1);
+#else
+
+static void interpolateRGBA_SIMD(tBilinearBatch * b)
+{
+    interpolateRGBA_C(b, 0);
+}
+
+#endif
+
+/* Filter the collected pixels and write them to their destinations */
+static void flushBatchRGBA(tBilinearBatch * b)
+{
+    int i;
+
+    if (b->simd) {
+	interpolateRGBA_SIMD(b);
+    } else {
+	interpolateRGBA_C(b, 0);
     }
-    if ((say = (int *) malloc((dst->h + 1) * sizeof(Uint32))) == NULL) {
-	free(sax);
-	return (-1);
+    for (i = 0; i < b->n; i++) {
+	*b->dp[i] = b->out[i];
+    }
+    b->n = 0;
+}
+
+/* 
+ 
+ Row parallel dispatch.
+
+ Targets of at least RZ_MT_MIN_PIXELS pixels are split in row ranges across
+ the engine job pool; smaller ones stay on the calling thread, where waking
+ the workers would cost more than the transform itself. The row functions
+ keep all their state on the stack, so they can run concurrently.
+ 
+*/
+
+#define RZ_MT_MIN_PIXELS 32768
+
+static void runRows(job_func func, void *job, SDL_Surface * dst)
+{
+    if (dst->w * dst->h >= RZ_MT_MIN_PIXELS) {
+	job_pool_for(func, job, dst->h);
+    } else {
+	func(job, 0, dst->h);
     }
+}
+
+/* 
+ 
+ 32bit Zoomer with optional anti-aliasing by bilinear interpolation.
+
+ Zoomes 32bit RGBA/ABGR 'src' surface to 'dst' surface.
+ 
+*/
+
+/* Row range job for zoomSurfaceRGBA() */
+typedef struct tZoomJobRGBA {
+    SDL_Surface *src, *dst;
+    int *sax, *say;
+    int flipx, flipy, smooth;
+} tZoomJobRGBA;
+
+static void zoomRowsRGBA(void *data, int first, int last)
+{
+    tZoomJobRGBA *job = (tZoomJobRGBA *) data;
+    SDL_Surface *src = job->src;
+    SDL_Surface *dst = job->dst;
+    int flipx = job->flipx, flipy = job->flipy;
+    int x, y, *csax, *csay, sstep;
+    tColorRGBA *c00, *c01, *c10, *c11;
+    tColorRGBA *sp, *csp, *dp;
+    tBilinearBatch batch;
+    int dgap;
 
     /*
-     * Precalculate row increments 
+     * Pointer setup 
      */
-    sp = csp = (tColorRGBA *) src->pixels;
-    dp = (tColorRGBA *) dst->pixels;
+    csp = (tColorRGBA *) src->pixels;
+    dp = (tColorRGBA *) ((Uint8 *) dst->pixels + first * dst->pitch);
 
     if (flipx) csp += (src->w-1);
     if (flipy) csp  = (tColorRGBA*)( (Uint8*)csp + src->pitch*(src->h-1) );
 
-    csx = 0;
-    csax = sax;
-    for (x = 0; x <= dst->w; x++) {
-	*csax = csx;
-	csax++;
-	csx &= 0xffff;
-	csx += sx;
-    }
-    csy = 0;
-    csay = say;
-    for (y = 0; y <= dst->h; y++) {
-	*csay = csy;
+    /*
+     * Skip source rows up to the first row of the range 
+     */
+    csay = job->say;
+    for (y = 0; y < first; y++) {
 	csay++;
-	csy &= 0xffff;
-	csy += sy;
+	sstep = (*csay >> 16) * src->pitch;
+	if (flipy && !job->smooth) sstep = -sstep;
+	csp = (tColorRGBA *) ((Uint8 *) csp + sstep);
     }
 
     dgap = dst->pitch - dst->w * 4;
@@ -91,17 +293,18 @@ int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
     /*
      * Switch between interpolating and non-interpolating code 
      */
-    if (smooth) {
+    if (job->smooth) {
 
 	/*
 	 * Interpolating Zoom 
 	 */
+	batch.n = 0;
+	batch.simd = useSIMD();
 
 	/*
 	 * Scan destination 
 	 */
-	csay = say;
-	for (y = 0; y < dst->h; y++) {
+	for (y = first; y < last; y++) {
 	    /*
 	     * Setup color source pointers 
 	     */
@@ -111,26 +314,22 @@ int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
 	    c10 = (tColorRGBA *) ((Uint8 *) csp + src->pitch);
 	    c11 = c10;
 	    c11++;
-	    csax = sax;
+	    csax = job->sax;
 	    for (x = 0; x < dst->w; x++) {
 
 		/*
-		 * Interpolate colors 
+		 * Collect colors for interpolation 
 		 */
-		ex = (*csax & 0xffff);
-		ey = (*csay & 0xffff);
-		t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
-		t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
-		dp->r = (((t2 - t1) * ey) >> 16) + t1;
-		t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
-		t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
-		dp->g = (((t2 - t1) * ey) >> 16) + t1;
-		t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
-		t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
-		dp->b = (((t2 - t1) * ey) >> 16) + t1;
-		t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
-		t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
-		dp->a = (((t2 - t1) * ey) >> 16) + t1;
+		batch.c00[batch.n] = *c00;
+		batch.c01[batch.n] = *c01;
+		batch.c10[batch.n] = *c10;
+		batch.c11[batch.n] = *c11;
+		batch.ex[batch.n] = (*csax & 0xffff);
+		batch.ey[batch.n] = (*csay & 0xffff);
+		batch.dp[batch.n] = dp;
+		if (++batch.n == RZ_BATCH) {
+		    flushBatchRGBA(&batch);
+		}
 
 		/*
 		 * Advance source pointers 
@@ -146,6 +345,9 @@ int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
 		 */
 		dp++;
 	    }
+	    if (batch.n > 0) {
+		flushBatchRGBA(&batch);
+	    }
 	    /*
 	     * Advance source pointer 
 	     */
@@ -163,10 +365,9 @@ int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
 	 * Non-Interpolating Zoom 
 	 */
 
-	csay = say;
-	for (y = 0; y < dst->h; y++) {
+	for (y = first; y < last; y++) {
 	    sp = csp;
-	    csax = sax;
+	    csax = job->sax;
 	    for (x = 0; x < dst->w; x++) {
 		/*
 		 * Draw 
@@ -199,6 +400,72 @@ int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
 	}
 
     }
+}
+
+int zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, int smooth)
+{
+    int x, y, sx, sy, *sax, *say, *csax, *csay, csx, csy;
+    tZoomJobRGBA job;
+
+    /*
+     * Variable setup 
+     */
+    if (smooth) {
+	/*
+	 * For interpolation: assume source dimension is one pixel 
+	 */
+	/*
+	 * smaller to avoid overflow on right and bottom edge.     
+	 */
+	sx = (int) (65536.0 * (float) (src->w - 1) / (float) dst->w);
+	sy = (int) (65536.0 * (float) (src->h - 1) / (float) dst->h);
+    } else {
+	sx = (int) (65536.0 * (float) src->w / (float) dst->w);
+	sy = (int) (65536.0 * (float) src->h / (float) dst->h);
+    }
+
+    /*
+     * Allocate memory for row increments 
+     */
+    if ((sax = (int *) malloc((dst->w + 1) * sizeof(Uint32))) == NULL) {
+	return (-1);
+    }
+    if ((say = (int *) malloc((dst->h + 1) * sizeof(Uint32))) == NULL) {
+	free(sax);
+	return (-1);
+    }
+
+    /*
+     * Precalculate row increments 
+     */
+    csx = 0;
+    csax = sax;
+    for (x = 0; x <= dst->w; x++) {
+	*csax = csx;
+	csax++;
+	csx &= 0xffff;
+	csx += sx;
+    }
+    csy = 0;
+    csay = say;
+    for (y = 0; y <= dst->h; y++) {
+	*csay = csy;
+	csay++;
+	csy &= 0xffff;
+	csy += sy;
+    }
+
+    /*
+     * Draw, split in row ranges for large targets 
+     */
+    job.src = src;
+    job.dst = dst;
+    job.sax = sax;
+    job.say = say;
+    job.flipx = flipx;
+    job.flipy = flipy;
+    job.smooth = smooth;
+    runRows(zoomRowsRGBA, &job, dst);
 
     /*
      * Remove temp arrays 
@@ -332,11 +599,24 @@ int zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy)
  
 */
 
-void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy, int smooth)
+/* Row range job for transformSurfaceRGBA() */
+typedef struct tTransformJobRGBA {
+    SDL_Surface *src, *dst;
+    int cx, cy, isin, icos;
+    int flipx, flipy, smooth;
+} tTransformJobRGBA;
+
+static void transformRowsRGBA(void *data, int first, int last)
 {
-    int x, y, t1, t2, dx, dy, xd, yd, sdx, sdy, ax, ay, ex, ey, sw, sh;
+    tTransformJobRGBA *job = (tTransformJobRGBA *) data;
+    SDL_Surface *src = job->src;
+    SDL_Surface *dst = job->dst;
+    int cx = job->cx, cy = job->cy, isin = job->isin, icos = job->icos;
+    int flipx = job->flipx, flipy = job->flipy;
+    int x, y, dx, dy, xd, yd, sdx, sdy, ax, ay, sw, sh;
     tColorRGBA c00, c01, c10, c11;
     tColorRGBA *pc, *sp, *spb;
+    tBilinearBatch batch;
     int gap;
 
     /*
@@ -348,14 +628,16 @@ void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy,
     ay = (cy << 16) - (isin * cx);
     sw = src->w - 1;
     sh = src->h - 1;
-    pc = dst->pixels;
+    pc = (tColorRGBA *) ((Uint8 *) dst->pixels + first * dst->pitch);
     gap = dst->pitch - dst->w * 4;
 
     /*
      * Switch between interpolating and non-interpolating code 
      */
-    if (smooth) {
-	for (y = 0; y < dst->h; y++) {
+    if (job->smooth) {
+	batch.n = 0;
+	batch.simd = useSIMD();
+	for (y = first; y < last; y++) {
 	    dy = cy - y;
 	    sdx = (ax + (isin * dy)) + xd;
 	    sdy = (ay - (icos * dy)) + yd;
@@ -434,22 +716,18 @@ void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy,
 			c11 = *sp;
 		    }
 		    /*
-		     * Interpolate colors 
+		     * Collect colors for interpolation 
 		     */
-		    ex = (sdx & 0xffff);
-		    ey = (sdy & 0xffff);
-		    t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
-		    t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
-		    pc->r = (((t2 - t1) * ey) >> 16) + t1;
-		    t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
-		    t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
-		    pc->g = (((t2 - t1) * ey) >> 16) + t1;
-		    t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
-		    t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
-		    pc->b = (((t2 - t1) * ey) >> 16) + t1;
-		    t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
-		    t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
-		    pc->a = (((t2 - t1) * ey) >> 16) + t1;
+		    batch.c00[batch.n] = c00;
+		    batch.c01[batch.n] = c01;
+		    batch.c10[batch.n] = c10;
+		    batch.c11[batch.n] = c11;
+		    batch.ex[batch.n] = (sdx & 0xffff);
+		    batch.ey[batch.n] = (sdy & 0xffff);
+		    batch.dp[batch.n] = pc;
+		    if (++batch.n == RZ_BATCH) {
+			flushBatchRGBA(&batch);
+		    }
 		}
 		sdx += icos;
 		sdy += isin;
@@ -457,8 +735,11 @@ void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy,
 	    }
 	    pc = (tColorRGBA *) ((Uint8 *) pc + gap);
 	}
+	if (batch.n > 0) {
+	    flushBatchRGBA(&batch);
+	}
     } else {
-	for (y = 0; y < dst->h; y++) {
+	for (y = first; y < last; y++) {
 	    dy = cy - y;
 	    sdx = (ax + (isin * dy)) + xd;
 	    sdy = (ay - (icos * dy)) + yd;
@@ -481,6 +762,25 @@ void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy,
     }
 }
 
+void transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy, int smooth)
+{
+    tTransformJobRGBA job;
+
+    /*
+     * Draw, split in row ranges for large targets 
+     */
+    job.src = src;
+    job.dst = dst;
+    job.cx = cx;
+    job.cy = cy;
+    job.isin = isin;
+    job.icos = icos;
+    job.flipx = flipx;
+    job.flipy = flipy;
+    job.smooth = smooth;
+    runRows(transformRowsRGBA, &job, dst);
+}
+
 /* 
  
  8bit Rotozoomer without smoothing
@@ -823,6 +1123,256 @@ SDL_Surface *rotozoomSurfaceXY(SDL_Surface * src, double angle, double zoomx, do
     return (rz_dst);
 }
 
+/* Publically available in-place rotozoom function */
+
+int rotozoomSurfaceXYInto(SDL_Surface * src, SDL_Surface * dst, double angle, double zoomx, double zoomy, int smooth,
+			  int *dstwidth, int *dstheight)
+{
+    SDL_Surface view;
+    double zoominv;
+    double sanglezoom, canglezoom;
+    int flipx, flipy;
+    int rotate, y, result;
+
+    /*
+     * Sanity check, only 32bit sources are transformed in place 
+     */
+    if ((src == NULL) || (src->format->BitsPerPixel != 32))
+	return (-1);
+
+    /*
+     * Sanity check zoom factor 
+     */
+    flipx = (zoomx<0);
+    if (flipx) zoomx=-zoomx;
+    flipy = (zoomy<0);
+    if (flipy) zoomy=-zoomy;
+    if (zoomx < VALUE_LIMIT) zoomx = VALUE_LIMIT;
+    if (zoomy < VALUE_LIMIT) zoomy = VALUE_LIMIT;
+
+    /*
+     * Determine target size exactly as rotozoomSurfaceXY() does 
+     */
+    rotate = (fabs(angle) > VALUE_LIMIT);
+    if (rotate) {
+	rotozoomSurfaceSizeTrig(src->w, src->h, angle, zoomx, zoomy, dstwidth, dstheight, &canglezoom, &sanglezoom);
+    } else {
+	zoomSurfaceSize(src->w, src->h, zoomx, zoomy, dstwidth, dstheight);
+    }
+
+    /*
+     * Caller has to (re)allocate the target 
+     */
+    if ((dst == NULL) || (dst->w < *dstwidth) || (dst->h < *dstheight))
+	return (-2);
+
+    /*
+     * Target must share the source RGBA/ABGR ordering 
+     */
+    if ((dst->format->BitsPerPixel != 32) ||
+	(dst->format->Rmask != src->format->Rmask) || (dst->format->Gmask != src->format->Gmask) ||
+	(dst->format->Bmask != src->format->Bmask))
+	return (-1);
+
+    SDL_LockSurface(src);
+    SDL_LockSurface(dst);
+
+    /*
+     * Work on a view of the used top-left area of the target 
+     */
+    view = *dst;
+    view.w = *dstwidth;
+    view.h = *dstheight;
+
+    result = 0;
+    if (rotate) {
+	/*
+	 * Transform only writes pixels covered by the source, clear the rest 
+	 */
+	for (y = 0; y < view.h; y++) {
+	    memset((Uint8 *) view.pixels + y * view.pitch, 0, view.w * 4);
+	}
+	zoominv = 65536.0 / (zoomx * zoomx);
+	transformSurfaceRGBA(src, &view, view.w / 2, view.h / 2,
+			     (int) (sanglezoom * zoominv), (int) (canglezoom * zoominv),
+			     flipx, flipy, smooth);
+    } else {
+	result = zoomSurfaceRGBA(src, &view, flipx, flipy, smooth);
+    }
+
+    SDL_UnlockSurface(dst);
+    SDL_UnlockSurface(src);
+
+    return (result);
+}
+
+/* 
+ 
+ Composite one source pixel over a destination pixel.
+
+ Same per-surface alpha formula as the SDL 32bit RGB blitters, so the result
+ matches a regular SDL_BlitSurface() of the transformed surface.
+ 
+*/
+
+static Uint32 blendPixelRGBA(Uint32 s, Uint32 d, Uint8 alpha)
+{
+    Uint32 s1, d1;
+
+    s1 = s & 0xff00ff;
+    d1 = d & 0xff00ff;
+    d1 = (d1 + ((s1 - d1) * alpha >> 8)) & 0xff00ff;
+    s &= 0xff00;
+    d &= 0xff00;
+    d = (d + ((s - d) * alpha >> 8)) & 0xff00;
+    return (d1 | d | 0xff000000);
+}
+
+/* Publically available single pass rotozoom blit */
+
+int rotozoomSurfaceXYBlit(SDL_Surface * src, SDL_Surface * dst, int x, int y, double angle, double zoomx, double zoomy,
+			  Uint32 flags, Uint32 colorkey, Uint8 alpha, SDL_Rect * dstrect)
+{
+    double zoominv;
+    double sanglezoom, canglezoom;
+    int dstwidth, dstheight, dstwidthhalf, dstheighthalf;
+    int flipx, flipy, rotate, usekey;
+    int x0, y0, cx1, cy1, cx2, cy2;
+    int px, py, lx, ly, sx, sy, dx, dy;
+    int isin, icos, xd, yd, ax, ay, sdx, sdy;
+    int stepx, stepy, csx;
+    Uint32 p, *sp, *dp;
+
+    /*
+     * Sanity check, only 32bit RGB surfaces with the same layout 
+     */
+    if ((src == NULL) || (dst == NULL))
+	return (-1);
+    if ((src->format->BitsPerPixel != 32) || (dst->format->BitsPerPixel != 32) || (src->format->Amask != 0))
+	return (-1);
+    if ((src->format->Rmask != dst->format->Rmask) || (src->format->Gmask != dst->format->Gmask) ||
+	(src->format->Bmask != dst->format->Bmask) || (src->format->Gmask != 0x0000ff00) ||
+	((src->format->Rmask | src->format->Gmask | src->format->Bmask) != 0x00ffffff))
+	return (-1);
+
+    /*
+     * Sanity check zoom factor 
+     */
+    flipx = (zoomx<0);
+    if (flipx) zoomx=-zoomx;
+    flipy = (zoomy<0);
+    if (flipy) zoomy=-zoomy;
+    if (zoomx < VALUE_LIMIT) zoomx = VALUE_LIMIT;
+    if (zoomy < VALUE_LIMIT) zoomy = VALUE_LIMIT;
+
+    /*
+     * Size and placement of the virtual rotated surface 
+     */
+    rotate = (fabs(angle) > VALUE_LIMIT);
+    if (rotate) {
+	rotozoomSurfaceSizeTrig(src->w, src->h, angle, zoomx, zoomy, &dstwidth, &dstheight, &canglezoom, &sanglezoom);
+    } else {
+	zoomSurfaceSize(src->w, src->h, zoomx, zoomy, &dstwidth, &dstheight);
+    }
+    dstwidthhalf = dstwidth / 2;
+    dstheighthalf = dstheight / 2;
+    x0 = x - dstwidthhalf;
+    y0 = y - dstheighthalf;
+
+    /*
+     * Clip against the destination clipping rectangle 
+     */
+    cx1 = MAX(x0, dst->clip_rect.x);
+    cy1 = MAX(y0, dst->clip_rect.y);
+    cx2 = MIN(x0 + dstwidth, dst->clip_rect.x + dst->clip_rect.w);
+    cy2 = MIN(y0 + dstheight, dst->clip_rect.y + dst->clip_rect.h);
+    if ((cx1 >= cx2) || (cy1 >= cy2)) {
+	if (dstrect) {
+	    dstrect->x = x0;
+	    dstrect->y = y0;
+	    dstrect->w = 0;
+	    dstrect->h = 0;
+	}
+	return (0);
+    }
+
+    usekey = (flags & SDL_SRCCOLORKEY) != 0;
+
+    SDL_LockSurface(src);
+    SDL_LockSurface(dst);
+
+    if (rotate) {
+	/*
+	 * Same fixed point setup as transformSurfaceRGBA() 
+	 */
+	zoominv = 65536.0 / (zoomx * zoomx);
+	isin = (int) (sanglezoom * zoominv);
+	icos = (int) (canglezoom * zoominv);
+	xd = ((src->w - dstwidth) << 15);
+	yd = ((src->h - dstheight) << 15);
+	ax = (dstwidthhalf << 16) - (icos * dstwidthhalf);
+	ay = (dstheighthalf << 16) - (isin * dstwidthhalf);
+
+	for (py = cy1; py < cy2; py++) {
+	    ly = py - y0;
+	    lx = cx1 - x0;
+	    dy = dstheighthalf - ly;
+	    sdx = (ax + (isin * dy)) + xd + icos * lx;
+	    sdy = (ay - (icos * dy)) + yd + isin * lx;
+	    dp = (Uint32 *) ((Uint8 *) dst->pixels + py * dst->pitch) + cx1;
+	    for (px = cx1; px < cx2; px++) {
+		dx = (short) (sdx >> 16);
+		dy = (short) (sdy >> 16);
+		if (flipx) dx = (src->w-1)-dx;
+		if (flipy) dy = (src->h-1)-dy;
+		if ((dx >= 0) && (dy >= 0) && (dx < src->w) && (dy < src->h)) {
+		    p = *((Uint32 *) ((Uint8 *) src->pixels + src->pitch * dy) + dx);
+		    if (!usekey || (p != colorkey)) {
+			*dp = (alpha == SDL_ALPHA_OPAQUE) ? p : blendPixelRGBA(p, *dp, alpha);
+		    }
+		}
+		sdx += icos;
+		sdy += isin;
+		dp++;
+	    }
+	}
+    } else {
+	/*
+	 * Same source stepping as zoomSurfaceRGBA() without smoothing 
+	 */
+	stepx = (int) (65536.0 * (float) src->w / (float) dstwidth);
+	stepy = (int) (65536.0 * (float) src->h / (float) dstheight);
+
+	for (py = cy1; py < cy2; py++) {
+	    sy = (int) (((long long) (py - y0) * stepy) >> 16);
+	    if (flipy) sy = (src->h-1)-sy;
+	    sp = (Uint32 *) ((Uint8 *) src->pixels + src->pitch * sy);
+	    dp = (Uint32 *) ((Uint8 *) dst->pixels + py * dst->pitch) + cx1;
+	    for (px = cx1; px < cx2; px++) {
+		csx = (int) (((long long) (px - x0) * stepx) >> 16);
+		sx = flipx ? (src->w-1)-csx : csx;
+		p = sp[sx];
+		if (!usekey || (p != colorkey)) {
+		    *dp = (alpha == SDL_ALPHA_OPAQUE) ? p : blendPixelRGBA(p, *dp, alpha);
+		}
+		dp++;
+	    }
+	}
+    }
+
+    SDL_UnlockSurface(dst);
+    SDL_UnlockSurface(src);
+
+    if (dstrect) {
+	dstrect->x = cx1;
+	dstrect->y = cy1;
+	dstrect->w = cx2 - cx1;
+	dstrect->h = cy2 - cy1;
+    }
+
+    return (0);
+}
+
 /* 
  
  zoomSurface()
@@ -32,6 +32,9 @@
 #include <string.h>
 #include <SFont.h>
 #include <log.h>
+#include <dirty_rect.h>
+#include <render_queue.h>
+#include <perf.h>
 
 
 
@@ -55,11 +58,11 @@ static Uint32 GetPixel(SDL_Surface *Surface, Sint32 X, Sint32 Y)
          return *((Uint16 *)Surface->pixels + Y * Surface->pitch/2 + X);
          break;
       case 3: { // Format/endian independent 
-         Uint8 r, g, b;
-         r = *((bits)+Surface->format->Rshift/8);
-         g = *((bits)+Surface->format->Gshift/8);
-         b = *((bits)+Surface->format->Bshift/8);
-         return SDL_MapRGB(Surface->format, r, g, b);
+         // 24 bits no pierde bits por canal: se coloca cada byte en su sitio
+         SDL_PixelFormat *f = Surface->format;
+         return ((Uint32)*(bits + f->Rshift/8) << f->Rshift) |
+                ((Uint32)*(bits + f->Gshift/8) << f->Gshift) |
+                ((Uint32)*(bits + f->Bshift/8) << f->Bshift) | f->Amask;
          }
          break;
       case 4:
@@ -144,6 +147,11 @@ void SFont_Write(SDL_Surface *Surface, const SFont_Font *Font, int x, int y, con
 
     if(text == NULL)
 		return;
+    if(Surface == render_queue_target()) {
+        // grabando: se escribe al cerrar la cola, agrupado con su hoja
+        render_queue_sfont(Font, x, y, text, render_queue_layer(), 0);
+        return;
+    }
 
     // these values won't change in the loop
     srcrect.y = 1;
@@ -174,7 +182,9 @@ void SFont_Write(SDL_Surface *Surface, const SFont_Font *Font, int x, int y, con
 			dstrect.x = (short)(x - ((Font->CharPos[charoffset] - Font->CharPos[charoffset-1]) >> 1)) + x_shake;
 			dstrect.y = (Sint16)(y + y_shake);
 
-			SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect); 
+			SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect);
+			dirty_rect_add(Surface, &dstrect);
+			PERF_COUNT(PERF_GLYPHS, 1);
 
 			x += Font->CharPos[charoffset+1] - Font->CharPos[charoffset];
 		}
@@ -207,7 +217,9 @@ void SFont_Write(SDL_Surface *Surface, const SFont_Font *Font, int x, int y, con
 
 			dstrect.y = (Sint16)(y + y_shake);
 
-			SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect); 
+			SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect);
+			dirty_rect_add(Surface, &dstrect);
+			PERF_COUNT(PERF_GLYPHS, 1);
 
 			x += Font->CharPos[charoffset+1] - Font->CharPos[charoffset];
 	    }
@@ -344,7 +356,9 @@ void SFont_WriteChopRight(SDL_Surface *Surface, const SFont_Font *Font,
 
 		dstrect.y = (Sint16)(y + y_shake);
 
-		SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect); 
+		SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect);
+		dirty_rect_add(Surface, &dstrect);
+		PERF_COUNT(PERF_GLYPHS, 1);
 
 		x += width;
     }
@@ -403,7 +417,9 @@ void SFont_WriteChopLeft(SDL_Surface *Surface, const SFont_Font *Font,
 
 		//x -= (width - srcrect.w);
 
-		SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect); 
+		SDL_BlitSurface(Font->Surface, &srcrect, Surface, &dstrect);
+		dirty_rect_add(Surface, &dstrect);
+		PERF_COUNT(PERF_GLYPHS, 1);
 		
     }
 }
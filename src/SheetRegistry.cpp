@@ -0,0 +1,308 @@
+#include <SheetRegistry.h>
+#include <Sprite.h>
+#include <SDL/SDL_image.h>
+#include <pixfmt.h>
+#include <perf.h>
+#include <cstdio>
+#include <map>
+#include <string>
+
+
+struct SheetEntry {
+    SDL_Surface *surface;       ///< Superficie compartida.
+    int refs;                   ///< Handles vivos.
+    std::string key;            ///< Clave en el registro (vacía si no está).
+};
+
+typedef std::map<std::string, SheetEntry*> SheetMap;
+
+static SheetMap& sheets() {
+    static SheetMap map;
+    return map;
+}
+
+static void release(SheetEntry *entry) {
+    if(!entry || --entry->refs > 0) {
+        return;
+    }
+    if(!entry->key.empty()) {
+        sheets().erase(entry->key);
+    }
+    SDL_FreeSurface(entry->surface);
+    delete entry;
+}
+
+static SheetEntry* newEntry(SDL_Surface *surface, const std::string &key) {
+    SheetEntry *entry = new SheetEntry;
+    entry->surface = surface;
+    entry->refs = 1;
+    entry->key = key;
+    if(!key.empty()) {
+        sheets()[key] = entry;
+    }
+    return entry;
+}
+
+
+SheetHandle::SheetHandle() : entry(NULL) {
+}
+
+SheetHandle::SheetHandle(SheetEntry *e) : entry(e) {
+}
+
+SheetHandle::~SheetHandle() {
+    release(entry);
+}
+
+SheetHandle::SheetHandle(SheetHandle &&other) : entry(other.entry) {
+    other.entry = NULL;
+}
+
+SheetHandle& SheetHandle::operator=(SheetHandle &&other) {
+    if(this != &other) {
+        release(entry);
+        entry = other.entry;
+        other.entry = NULL;
+    }
+    return *this;
+}
+
+SheetHandle SheetHandle::adopt(SDL_Surface *surface) {
+    if(!surface) {
+        return SheetHandle();
+    }
+    return SheetHandle(newEntry(surface, std::string()));
+}
+
+SheetHandle SheetHandle::share() const {
+    if(entry) {
+        entry->refs++;
+    }
+    return SheetHandle(entry);
+}
+
+bool SheetHandle::detach() {
+    if(!entry || entry->refs == 1) {
+        return entry != NULL;
+    }
+    SDL_Surface *src = entry->surface;
+    SDL_Surface *copy = SDL_ConvertSurface(src, src->format, src->flags);
+    if(!copy) {
+        printf("SDL_ConvertSurface error: %s\n", SDL_GetError());
+        return false;
+    }
+    PERF_COUNT(PERF_SURFACES, 1);
+    release(entry);
+    entry = newEntry(copy, std::string());
+    return true;
+}
+
+void SheetHandle::reset() {
+    release(entry);
+    entry = NULL;
+}
+
+SDL_Surface* SheetHandle::get() const {
+    return entry ? entry->surface : NULL;
+}
+
+bool SheetHandle::valid() const {
+    return entry != NULL;
+}
+
+bool SheetHandle::shared() const {
+    return entry && entry->refs > 1;
+}
+
+int SheetHandle::refs() const {
+    return entry ? entry->refs : 0;
+}
+
+
+SheetHandle SheetRegistry::loadFile(const char *file) {
+    if(!file) {
+        return SheetHandle();
+    }
+    std::string key = std::string("file:") + file;
+    SheetMap::iterator it = sheets().find(key);
+    if(it != sheets().end()) {
+        it->second->refs++;
+        return SheetHandle(it->second);
+    }
+    SDL_Surface *temp = IMG_Load(file);
+    if(!temp) {
+        printf("IMG_Load error: %s\n", IMG_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *surface = SDL_DisplayFormat(temp);
+    SDL_FreeSurface(temp);
+    if(!surface) {
+        return SheetHandle();
+    }
+    PERF_COUNT(PERF_SURFACES, 1);
+    return SheetHandle(newEntry(surface, key));
+}
+
+SheetHandle SheetRegistry::loadMemory(const u8 *buffer, int len) {
+    if(!buffer || len <= 0) {
+        return SheetHandle();
+    }
+    char key[64];
+    snprintf(key, sizeof(key), "mem:%p:%d", (const void*)buffer, len);
+    SheetMap::iterator it = sheets().find(key);
+    if(it != sheets().end()) {
+        it->second->refs++;
+        return SheetHandle(it->second);
+    }
+    SDL_RWops *mem_rwops = SDL_RWFromMem((void*)buffer, len);
+    if(!mem_rwops) {
+        printf("SDL_RWFromMem error: %s\n", SDL_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *temp = IMG_Load_RW(mem_rwops, 1);
+    if(!temp) {
+        printf("IMG_Load_RW error: %s\n", IMG_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *surface = SDL_DisplayFormat(temp);
+    SDL_FreeSurface(temp);
+    if(!surface) {
+        return SheetHandle();
+    }
+    PERF_COUNT(PERF_SURFACES, 1);
+    return SheetHandle(newEntry(surface, key));
+}
+
+/*
+  Deja `temp` en 8 bits: las imágenes con paleta se quedan como están, el
+  resto se convierte. Libera `temp` si devuelve otra superficie.
+  */
+static SDL_Surface* keepIndexed(SDL_Surface *temp) {
+    if(temp->format->BitsPerPixel == 8 && temp->format->palette) {
+        return temp;
+    }
+    SDL_Surface *indexed = SheetRegistry::convertIndexed(temp);
+    SDL_FreeSurface(temp);
+    return indexed;
+}
+
+SheetHandle SheetRegistry::loadFileIndexed(const char *file) {
+    if(!file) {
+        return SheetHandle();
+    }
+    std::string key = std::string("file8:") + file;
+    SheetMap::iterator it = sheets().find(key);
+    if(it != sheets().end()) {
+        it->second->refs++;
+        return SheetHandle(it->second);
+    }
+    SDL_Surface *temp = IMG_Load(file);
+    if(!temp) {
+        printf("IMG_Load error: %s\n", IMG_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *surface = keepIndexed(temp);
+    if(!surface) {
+        return SheetHandle();
+    }
+    PERF_COUNT(PERF_SURFACES, 1);
+    return SheetHandle(newEntry(surface, key));
+}
+
+SheetHandle SheetRegistry::loadMemoryIndexed(const u8 *buffer, int len) {
+    if(!buffer || len <= 0) {
+        return SheetHandle();
+    }
+    char key[64];
+    snprintf(key, sizeof(key), "mem8:%p:%d", (const void*)buffer, len);
+    SheetMap::iterator it = sheets().find(key);
+    if(it != sheets().end()) {
+        it->second->refs++;
+        return SheetHandle(it->second);
+    }
+    SDL_RWops *mem_rwops = SDL_RWFromMem((void*)buffer, len);
+    if(!mem_rwops) {
+        printf("SDL_RWFromMem error: %s\n", SDL_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *temp = IMG_Load_RW(mem_rwops, 1);
+    if(!temp) {
+        printf("IMG_Load_RW error: %s\n", IMG_GetError());
+        return SheetHandle();
+    }
+    SDL_Surface *surface = keepIndexed(temp);
+    if(!surface) {
+        return SheetHandle();
+    }
+    PERF_COUNT(PERF_SURFACES, 1);
+    return SheetHandle(newEntry(surface, key));
+}
+
+SDL_Surface* SheetRegistry::convertIndexed(SDL_Surface *src) {
+    if(!src) {
+        return NULL;
+    }
+    SDL_Surface *out = SDL_CreateRGBSurface(SDL_SWSURFACE, src->w, src->h, 8, 0, 0, 0, 0);
+    if(!out) {
+        return NULL;
+    }
+
+    // paleta exacta: cada color RGB distinto recibe un índice
+    std::map<Uint32, int> index;
+    SDL_Color colors[256];
+    bool useKey = (src->flags & SDL_SRCCOLORKEY) != 0;
+    int keyIndex = -1;
+    bool ok = true;
+
+    pixfmt scratch;
+    const pixfmt *srcFmt = pixfmt_get(src->format, &scratch);
+
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
+    }
+    for(int y = 0; y < src->h && ok; y++) {
+        Uint8 *row = (Uint8*)out->pixels + y * out->pitch;
+        for(int x = 0; x < src->w; x++) {
+            Uint32 p = SpriteEffects::getPixel(src, x, y);
+            Uint32 rgb = pixfmt_unpack_rgb(srcFmt, p);
+            std::map<Uint32, int>::iterator it = index.find(rgb);
+            int i;
+            if(it != index.end()) {
+                i = it->second;
+            } else {
+                if(index.size() == 256) {
+                    ok = false;
+                    break;
+                }
+                i = (int)index.size();
+                index[rgb] = i;
+                colors[i].r = (Uint8)(rgb >> 16);
+                colors[i].g = (Uint8)(rgb >> 8);
+                colors[i].b = (Uint8)rgb;
+                colors[i].unused = 0;
+            }
+            if(useKey && keyIndex < 0 && p == src->format->colorkey) {
+                keyIndex = i;
+            }
+            row[x] = (Uint8)i;
+        }
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+    if(!ok) {
+        printf("convertIndexed: more than 256 colors\n");
+        SDL_FreeSurface(out);
+        return NULL;
+    }
+
+    SDL_SetColors(out, colors, 0, (int)index.size());
+    if(useKey && keyIndex >= 0) {
+        SDL_SetColorKey(out, SDL_SRCCOLORKEY, keyIndex);
+    }
+    return out;
+}
+
+int SheetRegistry::count() {
+    return (int)sheets().size();
+}
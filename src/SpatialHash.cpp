@@ -0,0 +1,227 @@
+#include <SpatialHash.h>
+
+
+SpatialHash::SpatialHash(int cell, int nbuckets) {
+    cellSize = cell > 0 ? cell : 64;
+    int n = 1;
+    while(n < nbuckets) {
+        n <<= 1;
+    }
+    bucketMask = n - 1;
+    buckets.resize(n);
+    count = 0;
+    stampValue = 0;
+}
+
+int SpatialHash::cellOf(int v) const {
+    // división con redondeo hacia abajo también para coordenadas negativas
+    return v >= 0 ? v / cellSize : -((-v + cellSize - 1) / cellSize);
+}
+
+int SpatialHash::bucketOf(int cx, int cy) const {
+    return (int)(((Uint32)cx * 73856093u) ^ ((Uint32)cy * 19349663u)) & bucketMask;
+}
+
+bool SpatialHash::valid(int id) const {
+    return id >= 0 && id < (int)entities.size() && entities[id].used;
+}
+
+bool SpatialHash::touches(const Entity &a, const Entity &b) {
+    // mismo criterio que SpriteEffects::rectCollide: tocarse cuenta
+    return !(a.x + a.w < b.x || b.x + b.w < a.x || a.y + a.h < b.y || b.y + b.h < a.y);
+}
+
+void SpatialHash::link(int id) {
+    Entity &e = entities[id];
+    e.cx0 = cellOf(e.x);
+    e.cy0 = cellOf(e.y);
+    e.cx1 = cellOf(e.x + e.w);
+    e.cy1 = cellOf(e.y + e.h);
+    for(int cy = e.cy0; cy <= e.cy1; cy++) {
+        for(int cx = e.cx0; cx <= e.cx1; cx++) {
+            CellItem item;
+            item.id = id;
+            item.cx = cx;
+            item.cy = cy;
+            buckets[bucketOf(cx, cy)].push_back(item);
+        }
+    }
+}
+
+void SpatialHash::unlink(int id) {
+    Entity &e = entities[id];
+    for(int cy = e.cy0; cy <= e.cy1; cy++) {
+        for(int cx = e.cx0; cx <= e.cx1; cx++) {
+            std::vector<CellItem> &b = buckets[bucketOf(cx, cy)];
+            for(size_t i = 0; i < b.size(); i++) {
+                if(b[i].id == id && b[i].cx == cx && b[i].cy == cy) {
+                    b[i] = b.back();
+                    b.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int SpatialHash::insert(Sprite &sprite, int x, int y, void *user) {
+    int id = insertRect(x, y, sprite.getWidth(), sprite.getHeight(), user);
+    entities[id].sprite = &sprite;
+    return id;
+}
+
+int SpatialHash::insertRect(int x, int y, int w, int h, void *user) {
+    int id;
+    if(!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = (int)entities.size();
+        entities.push_back(Entity());
+        stamp.push_back(0);
+    }
+    Entity &e = entities[id];
+    e.x = x;
+    e.y = y;
+    e.w = w;
+    e.h = h;
+    e.sprite = NULL;
+    e.user = user;
+    e.used = true;
+    link(id);
+    count++;
+    return id;
+}
+
+void SpatialHash::move(int id, int x, int y) {
+    if(!valid(id)) {
+        return;
+    }
+    moveRect(id, x, y, entities[id].w, entities[id].h);
+}
+
+void SpatialHash::moveRect(int id, int x, int y, int w, int h) {
+    if(!valid(id)) {
+        return;
+    }
+    Entity &e = entities[id];
+    // dentro de las mismas celdas no hace falta tocar la tabla
+    if(cellOf(x) == e.cx0 && cellOf(y) == e.cy0 && cellOf(x + w) == e.cx1 && cellOf(y + h) == e.cy1) {
+        e.x = x;
+        e.y = y;
+        e.w = w;
+        e.h = h;
+        return;
+    }
+    unlink(id);
+    e.x = x;
+    e.y = y;
+    e.w = w;
+    e.h = h;
+    link(id);
+}
+
+void SpatialHash::remove(int id) {
+    if(!valid(id)) {
+        return;
+    }
+    unlink(id);
+    entities[id].used = false;
+    entities[id].sprite = NULL;
+    entities[id].user = NULL;
+    freeIds.push_back(id);
+    count--;
+}
+
+void SpatialHash::clear() {
+    for(size_t i = 0; i < buckets.size(); i++) {
+        buckets[i].clear();
+    }
+    entities.clear();
+    freeIds.clear();
+    stamp.clear();
+    count = 0;
+}
+
+int SpatialHash::findPairs(std::vector<SpatialPair> &out) {
+    out.clear();
+    for(size_t bi = 0; bi < buckets.size(); bi++) {
+        const std::vector<CellItem> &b = buckets[bi];
+        for(size_t i = 0; i < b.size(); i++) {
+            for(size_t j = i + 1; j < b.size(); j++) {
+                // la cubeta puede mezclar celdas distintas
+                if(b[i].cx != b[j].cx || b[i].cy != b[j].cy) {
+                    continue;
+                }
+                const Entity &ea = entities[b[i].id];
+                const Entity &eb = entities[b[j].id];
+                if(!touches(ea, eb)) {
+                    continue;
+                }
+                // el par se informa solo desde la primera celda que comparten
+                if(b[i].cx != SPRITE_MAX(ea.cx0, eb.cx0) || b[i].cy != SPRITE_MAX(ea.cy0, eb.cy0)) {
+                    continue;
+                }
+                SpatialPair p;
+                p.a = SPRITE_MIN(b[i].id, b[j].id);
+                p.b = SPRITE_MAX(b[i].id, b[j].id);
+                out.push_back(p);
+            }
+        }
+    }
+    return (int)out.size();
+}
+
+int SpatialHash::query(int x, int y, int w, int h, std::vector<int> &out) {
+    out.clear();
+    Entity q;
+    q.x = x;
+    q.y = y;
+    q.w = w;
+    q.h = h;
+
+    // marca por consulta para no repetir entidades que ocupan varias celdas
+    if(++stampValue == 0) {
+        for(size_t i = 0; i < stamp.size(); i++) {
+            stamp[i] = 0;
+        }
+        stampValue = 1;
+    }
+
+    for(int cy = cellOf(y); cy <= cellOf(y + h); cy++) {
+        for(int cx = cellOf(x); cx <= cellOf(x + w); cx++) {
+            const std::vector<CellItem> &b = buckets[bucketOf(cx, cy)];
+            for(size_t i = 0; i < b.size(); i++) {
+                int id = b[i].id;
+                if(b[i].cx != cx || b[i].cy != cy || stamp[id] == stampValue) {
+                    continue;
+                }
+                stamp[id] = stampValue;
+                if(touches(entities[id], q)) {
+                    out.push_back(id);
+                }
+            }
+        }
+    }
+    return (int)out.size();
+}
+
+Sprite* SpatialHash::getSprite(int id) {
+    return valid(id) ? entities[id].sprite : NULL;
+}
+
+void* SpatialHash::getUser(int id) {
+    return valid(id) ? entities[id].user : NULL;
+}
+
+int SpatialHash::getX(int id) {
+    return valid(id) ? entities[id].x : 0;
+}
+
+int SpatialHash::getY(int id) {
+    return valid(id) ? entities[id].y : 0;
+}
+
+int SpatialHash::size() {
+    return count;
+}
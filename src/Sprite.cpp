@@ -1,5 +1,20 @@
 #include <Sprite.h>
-#include <SDL/SDL_image.h>
+#include <cstring>
+#include <dirty_rect.h>
+#include <deferred.h>
+#include <render_queue.h>
+#include <pixfmt.h>
+#include <perf.h>
+#include <anim.h>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPRITE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPRITE_NEON
+#endif
 
 
 
@@ -16,9 +31,10 @@ SDL_Surface* Sprite::getCurrentFrame() {
     );
 
     if (!frameSurface) return NULL;
+    PERF_COUNT(PERF_SURFACES, 1);
 
     SDL_Rect srcRect;
-    srcRect.x = index * width;
+    srcRect.x = getFrame() * width;
     srcRect.y = 0;
     srcRect.w = (Uint16)width;
     srcRect.h = (Uint16)height;
@@ -35,147 +51,285 @@ SDL_Surface* Sprite::getCurrentFrame() {
 }
 
 
+SpriteFrame Sprite::getFrameView() {
+    return getFrameView(getFrame());
+}
+
+SpriteFrame Sprite::getFrameView(int frame) {
+    SpriteFrame view;
+    view.surface = sprite;
+    if(frame >= 0 && frame < (int)frameRects.size()) {
+        view.rect = frameRects[frame];
+    } else {
+        view.rect.x = 0;
+        view.rect.y = 0;
+        view.rect.w = 0;
+        view.rect.h = 0;
+    }
+    return view;
+}
+
+Sprite* Sprite::cacheFrames() {
+    frameCacheEnabled = true;
+    buildFrameCache();
+    return this;
+}
+
+SDL_Surface* Sprite::getFrameSurface(int frame) {
+    if(frame < 0 || frame >= (int)frameCache.size()) {
+        return NULL;
+    }
+    return frameCache[frame];
+}
+
+void Sprite::buildFrameRects() {
+    collisionMaskDirty = true;
+    frameRects.resize(sprite ? maxFrames : 0);
+    for(Uint32 i = 0; i < frameRects.size(); i++) {
+        frameRects[i].x = (Sint16)(i * width);
+        frameRects[i].y = 0;
+        frameRects[i].w = (Uint16)width;
+        frameRects[i].h = (Uint16)height;
+    }
+}
+
+void Sprite::buildFrameCache() {
+    freeFrameCache();
+    if(!frameCacheEnabled || !sprite) {
+        return;
+    }
+
+    // copia directa de filas: un blit se saltaría los píxeles del color key
+    SDL_LockSurface(sprite);
+    int bpp = sprite->format->BytesPerPixel;
+    for(Uint32 i = 0; i < frameRects.size(); i++) {
+        SDL_Surface* frame = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height,
+            sprite->format->BitsPerPixel, sprite->format->Rmask, sprite->format->Gmask,
+            sprite->format->Bmask, sprite->format->Amask);
+        if(frame) {
+            PERF_COUNT(PERF_SURFACES, 1);
+            for(Uint32 y = 0; y < height; y++) {
+                memcpy((Uint8*)frame->pixels + y * frame->pitch,
+                    (Uint8*)sprite->pixels + y * sprite->pitch + frameRects[i].x * bpp,
+                    width * bpp);
+            }
+            if(sprite->flags & SDL_SRCCOLORKEY) {
+                SDL_SetColorKey(frame, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite->format->colorkey);
+            }
+        }
+        frameCache.push_back(frame);
+    }
+    SDL_UnlockSurface(sprite);
+}
+
+void Sprite::buildCollisionMask() {
+    collisionMaskDirty = false;
+    collisionMask.clear();
+    collisionMaskPitch = (width + 63) / 64;
+    if(!sprite || frameRects.empty()) {
+        return;
+    }
+    collisionMask.assign(frameRects.size() * height * collisionMaskPitch, 0);
+
+    // sólido: distinto del color key o, sin color key, con alpha distinto de 0
+    bool usekey = (sprite->flags & SDL_SRCCOLORKEY) != 0;
+    Uint32 key = sprite->format->colorkey;
+    Uint32 amask = sprite->format->Amask;
+
+    SDL_LockSurface(sprite);
+    for(Uint32 f = 0; f < frameRects.size(); f++) {
+        Uint64* row = &collisionMask[f * height * collisionMaskPitch];
+        for(Uint32 y = 0; y < height; y++, row += collisionMaskPitch) {
+            for(Uint32 x = 0; x < width; x++) {
+                Uint32 p = SpriteEffects::getPixel(sprite, frameRects[f].x + x, y);
+                bool solid = usekey ? (p != key) : (amask == 0 || (p & amask) != 0);
+                if(solid) {
+                    row[x >> 6] |= (Uint64)1 << (x & 63);
+                }
+            }
+        }
+    }
+    SDL_UnlockSurface(sprite);
+}
+
+const Uint64* Sprite::getCollisionMask(int frame) {
+    if(collisionMaskDirty) {
+        buildCollisionMask();
+    }
+    if(frame < 0 || frame >= (int)frameRects.size() || collisionMask.empty()) {
+        return NULL;
+    }
+    return &collisionMask[frame * height * collisionMaskPitch];
+}
+
+int Sprite::getCollisionMaskPitch() {
+    if(collisionMaskDirty) {
+        buildCollisionMask();
+    }
+    return collisionMaskPitch;
+}
+
+void Sprite::freeFrameCache() {
+    for(Uint32 i = 0; i < frameCache.size(); i++) {
+        if(frameCache[i]) {
+            SDL_FreeSurface(frameCache[i]);
+        }
+    }
+    frameCache.clear();
+}
+
+
 Sprite::Sprite() {
     sprite = NULL;
     loaded = false;
     width = 0;
     height = 0;
-    speed = 0;
-    run = false;
-    loopToBeginning = true;
-    indexIterator = 0;
-    index = 0;
+    maxFrames = 0;
+    anim = ANIM_INVALID;
+    frameCacheEnabled = false;
+    collisionMaskPitch = 0;
+    collisionMaskDirty = true;
+    drawAlpha = 255;
+    tintR = tintG = tintB = 255;
+    lutFormat = NULL;
+    lutTint = 0;
+    lutDirty = true;
 }
 
 Sprite::Sprite(const char *file, int frames, int speed) {
-    SDL_Surface *temp = IMG_Load(file);
-    sprite = SDL_DisplayFormat(temp);
-    SDL_FreeSurface(temp);
+    anim = ANIM_INVALID;
+    frameCacheEnabled = false;
+    collisionMaskPitch = 0;
+    collisionMaskDirty = true;
+    drawAlpha = 255;
+    tintR = tintG = tintB = 255;
+    lutFormat = NULL;
+    lutTint = 0;
+    lutDirty = true;
+    // la hoja se comparte con los demás sprites que usen el mismo archivo
+    sheet = SheetRegistry::loadFile(file);
+    sprite = sheet.get();
     if(sprite == NULL) {
         //std::cout << "failed to load sprite " << file << std::endl;
         loaded = false;
         width = 0;
         height = 0;
-        this->speed = 0;
     } else {
       //  std::cout << "successfully loaded sprite " << file << std::endl;
         loaded = true;
         width = sprite->w/frames;
         height = sprite->h;
-        this->speed = speed;
-        run = true;
     }
     maxFrames = frames;
-    if(maxFrames > 1) {
-        run = true;
-    } else {
-        run = false;
-    }
-    lastAnimated = SDL_GetTicks();
-    index = 0;
-    indexIterator = 1;
-    loopToBeginning = true;
+    initAnimation(frames, sprite ? speed : 0, maxFrames > 1);
+    buildFrameRects();
 }
 
 Sprite::Sprite(u8* buffer, int len, int frames, int speed) {
-    sprite = nullptr;
     loaded = false;
-    run = false;
-    index = 0;
-    indexIterator = 0;
-    loopToBeginning = true;
+    width = 0;
+    height = 0;
+    frameCacheEnabled = false;
+    collisionMaskPitch = 0;
+    collisionMaskDirty = true;
+    drawAlpha = 255;
+    tintR = tintG = tintB = 255;
+    lutFormat = NULL;
+    lutTint = 0;
+    lutDirty = true;
+    anim = ANIM_INVALID;
     maxFrames = frames;
-    this->speed = speed;
-
-    // Cargar desde memoria
-    SDL_RWops* mem_rwops = SDL_RWFromMem(buffer, len);
-    if (!mem_rwops) {
-        printf("SDL_RWFromMem error: %s\n", SDL_GetError());
-        return;
-    }
-
-    SDL_Surface* temp = IMG_Load_RW(mem_rwops, 1);
-    if (!temp) {
-        printf("IMG_Load_RW error: %s\n", IMG_GetError());
-        return;
-    }
+    initAnimation(frames, speed, false);
 
-    sprite = SDL_DisplayFormat(temp);
-    SDL_FreeSurface(temp);
+    // Cargar desde memoria (compartida si el buffer ya se cargó)
+    sheet = SheetRegistry::loadMemory(buffer, len);
+    sprite = sheet.get();
 
     if (sprite) {
         width = sprite->w / maxFrames; // ancho por frame
         height = sprite->h;            // alto total
         loaded = true;
     }
+    buildFrameRects();
 }
 
 void Sprite::load(const char *file, int frames, int speed) {
-    SDL_Surface *temp = SDL_LoadBMP(file);
-    sprite = SDL_DisplayFormat(temp);
-    SDL_FreeSurface(temp);
+    useSheet(SheetRegistry::loadFile(file), frames, speed);
+}
+
+void Sprite::loadIndexed(const char *file, int frames, int speed) {
+    useSheet(SheetRegistry::loadFileIndexed(file), frames, speed);
+}
+
+void Sprite::loadIndexed(u8* buffer, int len, int frames, int speed) {
+    useSheet(SheetRegistry::loadMemoryIndexed(buffer, len), frames, speed);
+}
+
+void Sprite::useSheet(SheetHandle &&handle, int frames, int speed) {
+    sheet = std::move(handle);
+    sprite = sheet.get();
     if(sprite == NULL) {
         //std::cout << "failed to load sprite " << file << std::endl;
         loaded = false;
         width = 0;
         height = 0;
-        this->speed = 0;
     } else {
       //  std::cout << "successfully loaded sprite " << file << std::endl;
         loaded = true;
         width = sprite->w/frames;
         height = sprite->h;
-        this->speed = speed;
-        run = true;
     }
     maxFrames = frames;
-    if(maxFrames > 1) {
-        run = true;
-    } else {
-        run = false;
-    }
-    lastAnimated = SDL_GetTicks();
-    index = 0;
-    indexIterator = 1;
-    loopToBeginning = true;
+    initAnimation(frames, sprite ? speed : 0, maxFrames > 1);
+    palette.clear();
+    syncPalette();
+    buildFrameRects();
+    buildFrameCache();
 }
 
 
 
 Sprite::Sprite(SDL_Surface* surface, int frames, int speed) {
+    anim = ANIM_INVALID;
+    frameCacheEnabled = false;
+    collisionMaskPitch = 0;
+    collisionMaskDirty = true;
+    drawAlpha = 255;
+    tintR = tintG = tintB = 255;
+    lutFormat = NULL;
+    lutTint = 0;
+    lutDirty = true;
     if(surface == NULL) {
 
         sprite = NULL;
         loaded = false;
         width = 0; height = 0;
-        this->speed = 0;
     } else {
         // create a new surface
+        SDL_Surface* view;
         if(surface->flags & SDL_SRCCOLORKEY) {
-            sprite = SDL_CreateRGBSurfaceFrom(surface->pixels, surface->w, surface->h, surface->format->BitsPerPixel, surface->pitch,
+            view = SDL_CreateRGBSurfaceFrom(surface->pixels, surface->w, surface->h, surface->format->BitsPerPixel, surface->pitch,
                 surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, 0 );
         } else {
-            sprite = SDL_CreateRGBSurfaceFrom(surface->pixels, surface->w, surface->h, surface->format->BitsPerPixel, surface->pitch,
+            view = SDL_CreateRGBSurfaceFrom(surface->pixels, surface->w, surface->h, surface->format->BitsPerPixel, surface->pitch,
                 surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, surface->format->Amask );
         }
         if(surface->flags & SDL_SRCCOLORKEY) {
-            SDL_SetColorKey(sprite, SDL_RLEACCEL|SDL_SRCCOLORKEY, surface->format->colorkey );
+            SDL_SetColorKey(view, SDL_RLEACCEL|SDL_SRCCOLORKEY, surface->format->colorkey );
+        }
+        if(view && surface->format->palette) {
+            SDL_SetColors(view, surface->format->palette->colors, 0, surface->format->palette->ncolors);
         }
+        sheet = SheetHandle::adopt(view);
+        sprite = sheet.get();
+        syncPalette();
         loaded = true;
         width = sprite->w/frames;
         height = sprite->h;
-        this->speed = speed;
     }
     maxFrames = frames;
-    if(maxFrames > 1) {
-        run = true;
-    } else {
-        run = false;
-    }
-    lastAnimated = SDL_GetTicks();
-    indexIterator = 1;
-    index = 0;
-    loopToBeginning = true;
+    initAnimation(frames, surface ? speed : 0, maxFrames > 1);
+    buildFrameRects();
 }
 
 
@@ -185,21 +339,204 @@ Sprite* Sprite::draw(SDL_Surface* buffer, int x, int y) {
          //std::cout << "Failed to draw, Sprite not initialized!"<< std::endl;
          return this;
      }
+    Uint32 index = getFrame();
+    if(index >= frameRects.size()) {
+        return this;
+    }
+    if(buffer && (buffer == deferred_target() || buffer == render_queue_target())) {
+        queue(x, y);
+        return this;
+    }
+    PERF_COUNT(PERF_BLITS, 1);
+    PERF_COUNT(PERF_PIXELS, width * height);
+    if(isIndexed()) {
+        SpriteEffects::drawIndexed(*this, buffer, x, y);
+        return this;
+    }
+    if(drawAlpha != 255 || (tintR & tintG & tintB) != 255) {
+        // opacidad o tinte propios: se mezcla al dibujar sin tocar la hoja
+        SpriteEffects::drawBlended(*this, buffer, x, y);
+        return this;
+    }
     SDL_Rect dstrect;
     dstrect.x = x;
     dstrect.y = y;
     // this blits the current frame from the sprite sheet
-    SDL_Rect animRect;
-    animRect.x = width*index;
-    animRect.y = 0;
-    animRect.w = width;
-    animRect.h = height;
+    SDL_Rect animRect = frameRects[index];
     SDL_BlitSurface(sprite, &animRect, buffer,&dstrect);
+    dirty_rect_add(buffer, &dstrect);
     return this;
 }
 
+namespace {
+
+// estado del sprite al grabar: puede cambiar de frame, alpha o paleta antes de dibujarse
+struct QueuedIndexed {
+    SDL_Surface *sheet;
+    SDL_Rect rect;
+    int x, y;
+    Uint8 alpha;
+    int key;
+    Uint32 lut[256];
+};
+
+void drawQueuedIndexed(SDL_Surface *view, int ox, int oy, void *ctx) {
+    QueuedIndexed *q = (QueuedIndexed*)ctx;
+    SpriteEffects::drawIndexedFrame(q->sheet, q->rect, q->alpha, q->key, q->lut, view, q->x - ox, q->y - oy);
+}
+
+void drawRenderQueueIndexed(SDL_Surface *dst, void *ctx) {
+    drawQueuedIndexed(dst, 0, 0, ctx);
+}
+
+struct QueuedBlended {
+    SDL_Surface *sheet;
+    SDL_Rect rect;
+    int x, y;
+    Uint8 alpha;
+    Uint32 tint;
+    bool useKey;
+    Uint32 key;
+};
+
+void drawRenderQueueBlended(SDL_Surface *dst, void *ctx) {
+    QueuedBlended *q = (QueuedBlended*)ctx;
+    SpriteEffects::drawBlendedFrame(q->sheet, q->rect, q->alpha, q->tint, q->useKey, q->key, dst, q->x, q->y);
+}
+
+}
+
+void Sprite::queue(int x, int y) {
+    SDL_Surface *dst = deferred_target();
+    bool rq = !dst;
+    Uint32 index = getFrame();
+    SDL_Rect bounds;
+
+    if(rq) {
+        dst = render_queue_target();
+    }
+    if(!dst || !isSprite() || index >= frameRects.size()) {
+        return;
+    }
+    int bpp = dst->format->BytesPerPixel;
+    bounds.x = x;
+    bounds.y = y;
+    bounds.w = width;
+    bounds.h = height;
+    if(isIndexed() && (bpp == 2 || bpp == 4)) {
+        if(drawAlpha == 0) {
+            return;
+        }
+        // la tabla se copia aquí: al dibujar solo se lee la copia
+        QueuedIndexed *q = (QueuedIndexed*)(rq ? render_queue_alloc(sizeof(QueuedIndexed))
+                                               : deferred_alloc(sizeof(QueuedIndexed)));
+        if(!q || (rq ? render_queue_keep(sprite) : deferred_keep(sprite)) < 0) {
+            return;
+        }
+        q->sheet = sprite;
+        q->rect = frameRects[index];
+        q->x = x;
+        q->y = y;
+        q->alpha = drawAlpha;
+        q->key = (sprite->flags & SDL_SRCCOLORKEY) ? (int)(sprite->format->colorkey & 0xff) : -1;
+        memcpy(q->lut, getPaletteLUT(dst->format), sizeof(q->lut));
+        if(rq) {
+            render_queue_call(drawRenderQueueIndexed, q, &bounds, render_queue_layer(), 0);
+        } else {
+            deferred_call(drawQueuedIndexed, q, &bounds);
+        }
+        return;
+    }
+    if(!rq) {
+        deferred_blit_ex(sprite, &frameRects[index], x, y, 0, drawAlpha,
+            (tintR << 16) | (tintG << 8) | tintB);
+        return;
+    }
+    if(drawAlpha == 0) {
+        return;
+    }
+    if(!isIndexed() && (drawAlpha != 255 || (tintR & tintG & tintB) != 255)) {
+        // mezcla propia como en draw(), con el estado de ahora
+        QueuedBlended *q = (QueuedBlended*)render_queue_alloc(sizeof(QueuedBlended));
+        if(!q || render_queue_keep(sprite) < 0) {
+            return;
+        }
+        q->sheet = sprite;
+        q->rect = frameRects[index];
+        q->x = x;
+        q->y = y;
+        q->alpha = drawAlpha;
+        q->tint = getTint();
+        q->useKey = (sprite->flags & SDL_SRCCOLORKEY) != 0;
+        q->key = sprite->format->colorkey;
+        render_queue_call(drawRenderQueueBlended, q, &bounds, render_queue_layer(), 0);
+        return;
+    }
+    render_queue_blit(sprite, &frameRects[index], x, y, render_queue_layer(), 0);
+}
+
 Sprite::~Sprite() {
     destroy();
+    anim_destroy(anim);
+}
+
+Sprite::Sprite(Sprite &&other) : Sprite() {
+    *this = std::move(other);
+}
+
+Sprite& Sprite::operator=(Sprite &&other) {
+    if(this == &other) {
+        return *this;
+    }
+    destroy();
+    anim_destroy(anim);
+
+    loaded = other.loaded;
+    width = other.width;
+    height = other.height;
+    maxFrames = other.maxFrames;
+    anim = other.anim;
+    sheet = std::move(other.sheet);
+    sprite = other.sprite;
+    frameRects = std::move(other.frameRects);
+    frameCache = std::move(other.frameCache);
+    frameCacheEnabled = other.frameCacheEnabled;
+    collisionMask = std::move(other.collisionMask);
+    collisionMaskPitch = other.collisionMaskPitch;
+    collisionMaskDirty = other.collisionMaskDirty;
+    drawAlpha = other.drawAlpha;
+    tintR = other.tintR;
+    tintG = other.tintG;
+    tintB = other.tintB;
+    palette = std::move(other.palette);
+    paletteLUT = std::move(other.paletteLUT);
+    lutFormat = other.lutFormat;
+    lutTint = other.lutTint;
+    lutDirty = other.lutDirty;
+
+    // el origen queda como un sprite vacío
+    other.loaded = false;
+    other.sprite = NULL;
+    other.anim = ANIM_INVALID;
+    other.frameRects.clear();
+    other.frameCache.clear();
+    other.collisionMask.clear();
+    other.collisionMaskDirty = true;
+    other.palette.clear();
+    other.paletteLUT.clear();
+    other.lutDirty = true;
+    return *this;
+}
+
+bool Sprite::makeUnique() {
+    if(!sheet.shared()) {
+        return true;
+    }
+    if(!sheet.detach()) {
+        return false;
+    }
+    sprite = sheet.get();
+    return true;
 }
 
 
@@ -208,8 +545,7 @@ Sprite* Sprite::setTransparency(Uint8 r, Uint8 g, Uint8 b) {
          //std::cout << "Failed to set Transparency, Sprite not initialized!"<< std::endl;
          return this;
      }
-    SDL_SetColorKey(sprite, SDL_SRCCOLORKEY,SDL_MapRGB(sprite->format, r, g, b));
-    return this;
+    return setTransparency(SDL_MapRGB(sprite->format, r, g, b));
 }
 
 Sprite* Sprite::setTransparency(Uint32 colorkey) {
@@ -217,70 +553,78 @@ Sprite* Sprite::setTransparency(Uint32 colorkey) {
          //std::cout << "Failed to set Transparency, Sprite not initialized!"<< std::endl;
          return this;
      }
+    // con la hoja compartida solo se copia si el color clave cambia de verdad
+    if((sprite->flags & SDL_SRCCOLORKEY) && sprite->format->colorkey == colorkey) {
+        return this;
+    }
+    if(!makeUnique()) {
+        return this;
+    }
     SDL_SetColorKey(sprite, SDL_SRCCOLORKEY, colorkey);
+    collisionMaskDirty = true;
     return this;
 }
 
 Sprite* Sprite::setSpeed(int i) {
-    speed = i;
+    anim_set_speed(anim, i);
     return this;
 }
 
 int Sprite::getSpeed() {
-    return speed;
+    return anim_speed(anim);
 }
 
 Sprite* Sprite::start() {
-    run = true;
+    anim_set_running(anim, 1);
     return this;
 }
 
 Sprite* Sprite::restart() {
-    if(run) {
-        index = 0;
-        lastAnimated = SDL_GetTicks();
+    if(running()) {
+        anim_restart(anim);
     }
     return this;
 }
 
 
 Sprite* Sprite::animate() {
-    if(run) {
-        if(SDL_GetTicks() - lastAnimated > speed) {
-            lastAnimated = SDL_GetTicks();
-            index += indexIterator;
-            if(index >= maxFrames) {
-                if(loopToBeginning) {
-                    indexIterator = 1;
-                    index = 0;
-                } else {
-                    indexIterator = -1;
-                    index = maxFrames - 1;
-                }
-            } else if(index < 0) {
-                indexIterator = 1;
-                index = 0;
-            }
-        }
-    }
+    // el avance lo hace anim_update() una vez por frame desde Render()
+    anim_tick(anim);
     return this;
 }
 
 Sprite* Sprite::setLoopToBegin(bool loop) {
-    loopToBeginning = loop;
+    anim_set_loop(anim, loop);
     return this;
 }
 
 bool Sprite::running() {
-   return run;
+   return anim_running(anim);
 }
 
 Sprite* Sprite::stop() {
-    run = false;
-    index = 0;
+    anim_set_running(anim, 0);
+    anim_set_frame(anim, 0);
     return this;
 }
 
+int Sprite::getAnimation() {
+    return anim;
+}
+
+void Sprite::initAnimation(int frames, int speed, bool running) {
+    if(anim == ANIM_INVALID) {
+        anim = anim_create(frames, speed, running);
+        return;
+    }
+    // recarga sobre un sprite ya usado: se conserva el handle
+    anim_set_frames(anim, frames);
+    anim_set_speed(anim, speed);
+    anim_set_loop(anim, 1);
+    anim_set_running(anim, running);
+    anim_restart(anim);
+}
+
 bool Sprite::isSprite() {
     return loaded;
 }
@@ -306,6 +650,10 @@ int Sprite::setPixel(int x, int y, Uint8 r, Uint8 g, Uint8 b) {
 }
 
 int Sprite::setPixel(int x, int y, Uint32 pixel) {
+    if(!makeUnique()) {
+        return -1;
+    }
+    collisionMaskDirty = true;
     return SpriteEffects::setPixel(sprite, x, y, pixel);
 }
 
@@ -327,6 +675,10 @@ int Sprite::setPixel8(int x, int y, Uint8 pixel) {
          //std::cout << "Failed to set pixel, Sprite not initialized!"<< std::endl;
          return -1;
      }
+    if(!makeUnique()) {
+        return -1;
+    }
+    collisionMaskDirty = true;
     Uint8* pixels = (Uint8*)sprite->pixels;
     pixels[y * sprite->w + x] = pixel;
     return 0;
@@ -346,6 +698,10 @@ int Sprite::setPixel16(int x, int y, Uint16 pixel) {
         // std::cout << "Failed to set pixel, Sprite not initialized!"<< std::endl;
          return -1;
      }
+    if(!makeUnique()) {
+        return -1;
+    }
+    collisionMaskDirty = true;
     Uint16* pixels = (Uint16*)sprite->pixels;
     pixels[y * sprite->w + x] = pixel;
     return 0;
@@ -365,6 +721,10 @@ int Sprite::setPixel32(int x, int y, Uint32 pixel) {
          //std::cout << "Failed to set pixel, Sprite not initialized!"<< std::endl;
          return -1;
      }
+    if(!makeUnique()) {
+        return -1;
+    }
+    collisionMaskDirty = true;
     Uint32* pixels = (Uint32*)sprite->pixels;
     pixels[y * sprite->w + x] = pixel;
     return 0;
@@ -372,11 +732,11 @@ int Sprite::setPixel32(int x, int y, Uint32 pixel) {
 
 
 int Sprite::getFrame() {
-    return index;
+    return anim_frame(anim);
 }
 
 int Sprite::getFrameIterator() {
-    return indexIterator;
+    return anim_direction(anim);
 }
 
 int Sprite::getMaxFrames() {
@@ -390,6 +750,7 @@ int Sprite::getWidth() { // this is most likely the width a user will need to kn
 
 Sprite* Sprite::setWidth(int width) {
     this->width = width;
+    buildFrameRects();
     return this;
 }
 
@@ -403,6 +764,7 @@ int Sprite::getHeight() { // in this Class the frame height is the same as the s
 
 Sprite* Sprite::setHeight(int height) {
     this->height = height;
+    buildFrameRects();
     return this;
 }
 
@@ -410,7 +772,7 @@ int Sprite::getSpriteHeight() { // sprites Actual height
     return sprite->h;
 }
 
-bool Sprite::equals(Sprite cmp) {
+bool Sprite::equals(Sprite &cmp) {
      if(sprite == cmp.getSurface()) {
          return true;
      }
@@ -422,7 +784,13 @@ SDL_Surface* Sprite::getSurface() {
 }
 
 Sprite* Sprite::setSurface(SDL_Surface* surface) {
-    sprite = surface;
+    if(surface != sprite) {
+        sheet = SheetHandle::adopt(surface);
+        sprite = sheet.get();
+    }
+    syncPalette();
+    buildFrameRects();
+    buildFrameCache();
     return this;
 }
 
@@ -463,6 +831,105 @@ Sprite* Sprite::flipVertical() {
     return this;
 }
 
+Sprite* Sprite::setAlpha(Uint8 alpha) {
+    drawAlpha = alpha;
+    return this;
+}
+
+Uint8 Sprite::getAlpha() {
+    return drawAlpha;
+}
+
+Sprite* Sprite::setTint(Uint8 r, Uint8 g, Uint8 b) {
+    tintR = r;
+    tintG = g;
+    tintB = b;
+    return this;
+}
+
+Uint32 Sprite::getTint() {
+    if(!isSprite()) {
+        return 0xffffffff;
+    }
+    // los bits que no son de color quedan a 1 para que el tinte no los toque
+    SDL_PixelFormat *fmt = sprite->format;
+    return SDL_MapRGB(fmt, tintR, tintG, tintB) | ~(fmt->Rmask | fmt->Gmask | fmt->Bmask);
+}
+
+bool Sprite::isIndexed() {
+    return sprite && sprite->format->BitsPerPixel == 8 && !palette.empty();
+}
+
+void Sprite::syncPalette() {
+    lutDirty = true;
+    if(!sprite || sprite->format->BitsPerPixel != 8 || !sprite->format->palette) {
+        palette.clear();
+        paletteLUT.clear();
+        return;
+    }
+    // una paleta propia ya modificada se conserva tras voltear o rotar
+    if(palette.empty()) {
+        resetPalette();
+    }
+}
+
+Sprite* Sprite::resetPalette() {
+    if(!sprite || !sprite->format->palette) {
+        return this;
+    }
+    SDL_Palette *pal = sprite->format->palette;
+    SDL_Color black = {0, 0, 0, 0};
+    palette.assign(256, black);
+    for(int i = 0; i < pal->ncolors && i < 256; i++) {
+        palette[i] = pal->colors[i];
+    }
+    lutDirty = true;
+    return this;
+}
+
+Sprite* Sprite::setPaletteColor(int index, Uint8 r, Uint8 g, Uint8 b) {
+    if(index < 0 || index >= (int)palette.size()) {
+        return this;
+    }
+    palette[index].r = r;
+    palette[index].g = g;
+    palette[index].b = b;
+    lutDirty = true;
+    return this;
+}
+
+Sprite* Sprite::setPalette(const SDL_Color *colors, int first, int count) {
+    for(int i = 0; i < count && first + i < (int)palette.size(); i++) {
+        if(first + i >= 0) {
+            palette[first + i] = colors[i];
+        }
+    }
+    lutDirty = true;
+    return this;
+}
+
+const Uint32* Sprite::getPaletteLUT(SDL_PixelFormat *fmt) {
+    if(palette.empty() || !fmt) {
+        return NULL;
+    }
+    Uint32 tint = (tintR << 16) | (tintG << 8) | tintB;
+    if(!lutDirty && lutFormat == fmt && lutTint == tint) {
+        return &paletteLUT[0];
+    }
+    // 256 conversiones por cambio de paleta, tinte o destino
+    paletteLUT.resize(256);
+    for(int i = 0; i < 256; i++) {
+        Uint8 r = (palette[i].r * (tintR + 1)) >> 8;
+        Uint8 g = (palette[i].g * (tintG + 1)) >> 8;
+        Uint8 b = (palette[i].b * (tintB + 1)) >> 8;
+        paletteLUT[i] = SDL_MapRGB(fmt, r, g, b);
+    }
+    lutFormat = fmt;
+    lutTint = tint;
+    lutDirty = false;
+    return &paletteLUT[0];
+}
+
 Sprite* Sprite::fade(float f) {
     SpriteEffects::fade(*this, f);
     return this;
@@ -494,13 +961,162 @@ Sprite* Sprite::stretch(float x,float y) {
 }
 
 Sprite* Sprite::destroy() {
-    if(isSprite()) {
-        SDL_FreeSurface(sprite);
-    }
+    freeFrameCache();
+    // la superficie se libera cuando la suelta el último sprite que la usa
+    sheet.reset();
+    sprite = NULL;
+    loaded = false;
     return this;
 }
 
 
+/*
+  Núcleos por fila para SpriteEffects. Se especializan por bytes por píxel
+  para que cada copia sea un solo acceso en lugar de un switch por píxel.
+  */
+
+// lado del bloque usado en las rotaciones de 90/270 grados
+#define SPRITE_TILE 32
+
+template<int BPP>
+static inline void copyPixel(Uint8 *dst, const Uint8 *src) {
+    memcpy(dst, src, BPP);
+}
+
+template<int BPP>
+static void reverseRow(Uint8 *dst, const Uint8 *src, int w) {
+    const Uint8 *s = src + (w - 1) * BPP;
+    for(int x = 0; x < w; x++, dst += BPP, s -= BPP) {
+        copyPixel<BPP>(dst, s);
+    }
+}
+
+#if defined(SPRITE_SSE2) || defined(SPRITE_NEON)
+template<>
+void reverseRow<4>(Uint8 *dst, const Uint8 *src, int w) {
+    const Uint8 *s = src + w * 4;
+    int x = 0;
+    // cuatro píxeles por iteración con el orden de los carriles invertido
+    for(; x + 4 <= w; x += 4) {
+        s -= 16;
+#ifdef SPRITE_SSE2
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+#else
+        uint32x4_t v = vrev64q_u32(vld1q_u32((const uint32_t*)s));
+        vst1q_u32((uint32_t*)(dst + x * 4), vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+#endif
+    }
+    for(; x < w; x++) {
+        s -= 4;
+        copyPixel<4>(dst + x * 4, s);
+    }
+}
+#endif
+
+/*
+  Rota un frame de w x h píxeles. Se recorre por bloques para que tanto las
+  lecturas como las escrituras en columna se queden en caché.
+  90:  (x,y) -> (h-1-y, x)
+  270: (x,y) -> (y, w-1-x)
+  */
+template<int BPP>
+static void rotateFrame(const Uint8 *src, int spitch, Uint8 *dst, int dpitch, int w, int h, int deg) {
+    int step = (deg == 90) ? dpitch : -dpitch;
+    for(int ty = 0; ty < h; ty += SPRITE_TILE) {
+        int ey = SPRITE_MIN(ty + SPRITE_TILE, h);
+        for(int tx = 0; tx < w; tx += SPRITE_TILE) {
+            int ex = SPRITE_MIN(tx + SPRITE_TILE, w);
+            for(int y = ty; y < ey; y++) {
+                const Uint8 *s = src + y * spitch + tx * BPP;
+                Uint8 *d;
+                if(deg == 90) {
+                    d = dst + tx * dpitch + (h - 1 - y) * BPP;
+                } else {
+                    d = dst + (w - 1 - tx) * dpitch + y * BPP;
+                }
+                for(int x = tx; x < ex; x++, s += BPP, d += step) {
+                    copyPixel<BPP>(d, s);
+                }
+            }
+        }
+    }
+}
+
+template<int BPP>
+static void scaleRow(Uint8 *dst, const Uint8 *src, const int *xoff, int w) {
+    for(int x = 0; x < w; x++, dst += BPP) {
+        copyPixel<BPP>(dst, src + xoff[x]);
+    }
+}
+
+template<int BPP>
+static void flipSurface(SDL_Surface *src, SDL_Surface *dst, int val) {
+    for(int y = 0; y < src->h; y++) {
+        const Uint8 *s = (const Uint8*)src->pixels + y * src->pitch;
+        if(val == FLIP_HORIZONTAL) {
+            reverseRow<BPP>((Uint8*)dst->pixels + y * dst->pitch, s, src->w);
+        } else {
+            memcpy((Uint8*)dst->pixels + (src->h - 1 - y) * dst->pitch, s, src->w * BPP);
+        }
+    }
+}
+
+template<int BPP>
+static void rotateSurface(SDL_Surface *src, SDL_Surface *dst, int w, int h, int frames, int deg) {
+    for(int i = 0; i < frames; i++) {
+        const Uint8 *s = (const Uint8*)src->pixels + i * w * BPP;
+        if(deg == 180) {
+            for(int y = 0; y < h; y++) {
+                reverseRow<BPP>((Uint8*)dst->pixels + (h - 1 - y) * dst->pitch + i * w * BPP, s + y * src->pitch, w);
+            }
+        } else {
+            rotateFrame<BPP>(s, src->pitch, (Uint8*)dst->pixels + i * h * BPP, dst->pitch, w, h, deg);
+        }
+    }
+}
+
+template<int BPP>
+static void stretchSurface(SDL_Surface *src, SDL_Surface *dst, int srcWidth, int frames, float stretchX, float stretchY) {
+    int w = dst->w / frames;
+    std::vector<int> xoff(w);
+    for(int x = 0; x < w; x++) {
+        xoff[x] = (int)(x / stretchX) * BPP;
+    }
+    for(int y = 0; y < dst->h; y++) {
+        const Uint8 *s = (const Uint8*)src->pixels + (int)(y / stretchY) * src->pitch;
+        Uint8 *d = (Uint8*)dst->pixels + y * dst->pitch;
+        // cada animación se escala por separado
+        for(int i = 0; i < frames; i++) {
+            scaleRow<BPP>(d + i * w * BPP, s + i * srcWidth * BPP, &xoff[0], w);
+        }
+    }
+}
+
+/*
+  Crea una superficie vacía con el formato de otra. El canal alfa solo se
+  conserva cuando la original usa color clave.
+  */
+static SDL_Surface* createLike(SDL_Surface *src, int w, int h) {
+    Uint32 amask = (src->flags & SDL_SRCCOLORKEY) ? src->format->Amask : 0;
+    SDL_Surface *s = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, src->format->BitsPerPixel,
+        src->format->Rmask, src->format->Gmask, src->format->Bmask, amask);
+    if(s && src->format->palette) {
+        SDL_SetColors(s, src->format->palette->colors, 0, src->format->palette->ncolors);
+    }
+    if(s) {
+        PERF_COUNT(PERF_SURFACES, 1);
+    }
+    return s;
+}
+
+static void copyColorKey(SDL_Surface *src, SDL_Surface *dst) {
+    if(src->flags & SDL_SRCCOLORKEY) {
+        SDL_SetColorKey(dst, SDL_RLEACCEL|SDL_SRCCOLORKEY, src->format->colorkey );
+    }
+}
+
+
 /*
   SpriteEffects functions
   */
@@ -511,25 +1127,31 @@ SDL_Surface* SpriteEffects::getRect(Sprite &sprite, int x, int y, int w, int h)
          //std::cout << "Failed to get Rectangle, Sprite not initialized!"<< std::endl;
          return NULL;
      }
-    SDL_Surface* newrect;
-    // create a new surface
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        newrect = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, sprite.getSurface()->format->BitsPerPixel,
-            sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, sprite.getSurface()->format->Amask );
-    } else {
-        newrect = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, sprite.getSurface()->format->BitsPerPixel,
-            sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, 0 );
+    SDL_Surface* src = sprite.getSurface();
+    SDL_Surface* newrect = createLike(src, w, h);
+    if(!newrect) {
+        return NULL;
     }
-
-    for(int j = 0; j < h; j++) {
-        for(int i = 0; i < w; i++) {
-            setPixel(newrect, i, j, sprite.getPixel(x+i,y+j));
+    // solo se copia la parte que cae dentro de la hoja
+    int x1 = SPRITE_MAX(x, 0);
+    int y1 = SPRITE_MAX(y, 0);
+    int x2 = SPRITE_MIN(x + w, src->w);
+    int y2 = SPRITE_MIN(y + h, src->h);
+    if(x1 < x2 && y1 < y2) {
+        int bpp = src->format->BytesPerPixel;
+        if(SDL_MUSTLOCK(src)) {
+            SDL_LockSurface(src);
+        }
+        for(int j = y1; j < y2; j++) {
+            memcpy((Uint8*)newrect->pixels + (j - y) * newrect->pitch + (x1 - x) * bpp,
+                   (Uint8*)src->pixels + j * src->pitch + x1 * bpp, (x2 - x1) * bpp);
+        }
+        if(SDL_MUSTLOCK(src)) {
+            SDL_UnlockSurface(src);
         }
     }
     //Copy color key
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        SDL_SetColorKey(newrect, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite.getSurface()->format->colorkey );
-    }
+    copyColorKey(src, newrect);
     return newrect;
 }
 
@@ -560,24 +1182,59 @@ bool SpriteEffects::rectCollide(Sprite &spriteA, int aX, int aY, Sprite &spriteB
     return true;
 }
 
+/*
+  bits [offset, offset+64) of a mask row, zero past the end of the row
+  */
+static Uint64 maskBits64(const Uint64* row, int pitch, int offset) {
+    int w = offset >> 6;
+    int s = offset & 63;
+    Uint64 v = row[w] >> s;
+    if(s && w + 1 < pitch) {
+        v |= row[w + 1] << (64 - s);
+    }
+    return v;
+}
+
 bool SpriteEffects::pixelCollide(Sprite &spriteA, int aX, int aY, Sprite &spriteB, int bX, int bY) {
 	/*check if bounding boxes intersect*/
 	if(!rectCollide(spriteA, aX, aY, spriteB, bX, bY)) {
          return false;
     }
 
-    // get the overlaping box
+    // get the overlaping box, [x0,x1) x [y0,y1)
 	int inter_x0 = SPRITE_MAX(bX,aX);
 	int inter_x1 = SPRITE_MIN(bX+spriteB.getWidth(),aX+spriteA.getWidth());
 
 	int inter_y0 = SPRITE_MAX(bY,aY);
 	int inter_y1 = SPRITE_MIN(bY+spriteB.getHeight(),aY+spriteA.getHeight());
 
-	for(int y = inter_y0 ; y <= inter_y1 ; y++) {
-		for(int x = inter_x0 ; x <= inter_x1 ; x++) {
-		    /*compute offsets for surface, but dont forget to account for the current animation*/
-            if((!spriteB.isTransparentPixel(x-aX + spriteB.getFrame() * spriteB.getWidth() , y-bY))
-			&& (!spriteA.isTransparentPixel(x-aX + spriteA.getFrame() * spriteA.getWidth(), y-aY))) {/*before pass to isTransparentPixel*/
+	if(inter_x0 >= inter_x1 || inter_y0 >= inter_y1) {
+		return false;
+	}
+
+	/*1 bit per pixel masks of the current animation frames*/
+	const Uint64* maskA = spriteA.getCollisionMask(spriteA.getFrame());
+	const Uint64* maskB = spriteB.getCollisionMask(spriteB.getFrame());
+	if(!maskA || !maskB) {
+		return false;
+	}
+	int pitchA = spriteA.getCollisionMaskPitch();
+	int pitchB = spriteB.getCollisionMaskPitch();
+
+	int offA = inter_x0 - aX;
+	int offB = inter_x0 - bX;
+	int bits = inter_x1 - inter_x0;
+
+	for(int y = inter_y0 ; y < inter_y1 ; y++) {
+		const Uint64* rowA = maskA + (y - aY) * pitchA;
+		const Uint64* rowB = maskB + (y - bY) * pitchB;
+		/*64 pixels per AND, the last word cut to the overlap width*/
+		for(int k = 0 ; k < bits ; k += 64) {
+			Uint64 hit = maskBits64(rowA, pitchA, offA + k) & maskBits64(rowB, pitchB, offB + k);
+			if(bits - k < 64) {
+				hit &= ((Uint64)1 << (bits - k)) - 1;
+			}
+			if(hit) {
 				return true;
 			}
 		}
@@ -590,36 +1247,30 @@ void SpriteEffects::flip(Sprite &sprite, int val) {
          //std::cout << "Failed to flip, Sprite not initialized!"<< std::endl;
          return;
      }
-    SDL_Surface* flipped;
+    if(val != FLIP_HORIZONTAL && val != FLIP_VERTICAL) {
+        return;
+    }
+    SDL_Surface* src = sprite.getSurface();
     // create a new surface
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        flipped = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w, sprite.getSurface()->h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, sprite.getSurface()->format->Amask  );
-    } else {
-        flipped = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w, sprite.getSurface()->h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, 0 );
+    SDL_Surface* flipped = createLike(src, src->w, src->h);
+    if(!flipped) {
+        return;
     }
     // check to see if the surface must be locked
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_LockSurface(sprite.getSurface());
-    }
-    for(int y = 0; y < sprite.getSurface()->h; y++) {
-        for(int x = 0; x < sprite.getSurface()->w; x++) {
-            if(val == FLIP_HORIZONTAL) {
-                setPixel(flipped, sprite.getSurface()->w - 1 - x, y, sprite.getPixel(x,y));
-            } else if(val == FLIP_VERTICAL) {
-                setPixel(flipped, x, sprite.getSurface()->h - 1 - y, sprite.getPixel(x,y));
-            }
-        }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
     }
-    //Copy color key
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        SDL_SetColorKey(flipped, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite.getSurface()->format->colorkey );
+    switch(src->format->BytesPerPixel) {
+        case 1: flipSurface<1>(src, flipped, val); break;
+        case 2: flipSurface<2>(src, flipped, val); break;
+        case 3: flipSurface<3>(src, flipped, val); break;
+        case 4: flipSurface<4>(src, flipped, val); break;
     }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_UnlockSurface(sprite.getSurface());
+    //Copy color key
+    copyColorKey(src, flipped);
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
     }
-    SDL_FreeSurface(sprite.getSurface());
     sprite.setSurface(flipped);
 }
 
@@ -649,61 +1300,328 @@ void SpriteEffects::rotate(Sprite &sprite, int deg) {
          //std::cout << "Failed to rotate animation, Sprite not initialized!"<< std::endl;
          return;
      }
-    SDL_Surface* rotated;
+    SDL_Surface* src = sprite.getSurface();
+    int frames = sprite.getMaxFrames();
+    int fw = sprite.getWidth();
+    int fh = sprite.getHeight();
     int w,h;
     if(deg == 90 || deg == 270) {
-        w = sprite.getHeight() * sprite.getMaxFrames();
-        h = sprite.getWidth();
+        w = fh * frames;
+        h = fw;
     } else if(deg == 180) {
-        w = sprite.getWidth() * sprite.getMaxFrames();
-        h = sprite.getHeight();
+        w = fw * frames;
+        h = fh;
     } else {
         return;
     }
     // create a new surface
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        rotated = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, sprite.getSurface()->format->Amask  );
-    } else {
-        rotated = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, 0 );
+    SDL_Surface* rotated = createLike(src, w, h);
+    if(!rotated) {
+        return;
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
     }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_LockSurface(sprite.getSurface());
+    switch(src->format->BytesPerPixel) {
+        case 1: rotateSurface<1>(src, rotated, fw, fh, frames, deg); break;
+        case 2: rotateSurface<2>(src, rotated, fw, fh, frames, deg); break;
+        case 3: rotateSurface<3>(src, rotated, fw, fh, frames, deg); break;
+        case 4: rotateSurface<4>(src, rotated, fw, fh, frames, deg); break;
     }
+    sprite.setWidth( rotated->w/frames );
+    sprite.setHeight( rotated->h );
+    copyColorKey(src, rotated);
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+    sprite.setSurface(rotated);
+}
 
 
-    for(int i = 0; i < sprite.getMaxFrames(); i++) {
-        for(int y = 0; y < sprite.getHeight(); y++) {
-            for(int x = 0; x < sprite.getWidth(); x++) {
-                if(deg == 90) {
-                    setPixel(rotated, sprite.getHeight() * i + sprite.getHeight() - y - 1, x, sprite.getPixel((i * sprite.getWidth()) + x,y));
-                } else if(deg == 180) {
-                    setPixel(rotated, sprite.getWidth() * i + sprite.getWidth() - x - 1, rotated->h - y - 1, sprite.getPixel((i * sprite.getWidth()) + x,y));
-                } else if(deg == 270) {
-                    setPixel(rotated, sprite.getHeight() * i + y, rotated->h - x - 1, sprite.getPixel((i * sprite.getWidth()) + x,y));
-                } else {
-                    return;
+
+void SpriteEffects::fade(Sprite &sprite, float fade) {
+    if(fade < 0) {
+        fade = 0;
+    } else if(fade > 100) {
+        fade = 100;
+    }
+    sprite.setAlpha((Uint8)(fade * 255 / 100 + 0.5f));
+}
+
+/*
+  Mezcla por canal con alpha a en [0,256] y tinte t en [1,256]:
+      s' = (s * t) >> 8
+      d' = (s' * a + d * (256 - a)) >> 8
+  Todos los productos caben en 16 bits, así que las versiones SIMD dan
+  exactamente el mismo resultado que la escalar.
+  */
+static inline Uint32 blendPixel(Uint32 s, Uint32 d, Uint32 a, Uint32 tint) {
+    Uint32 out = 0;
+    for(int shift = 0; shift < 32; shift += 8) {
+        Uint32 sc = (((s >> shift) & 0xff) * (((tint >> shift) & 0xff) + 1)) >> 8;
+        Uint32 dc = (d >> shift) & 0xff;
+        out |= ((sc * a + dc * (256 - a)) >> 8) << shift;
+    }
+    return out;
+}
+
+void SpriteEffects::blendRowScalar(Uint32 *dst, const Uint32 *src, int n, Uint32 key, bool useKey, Uint8 alpha, Uint32 tint) {
+    Uint32 a = alpha + (alpha >> 7);
+    for(int i = 0; i < n; i++) {
+        if(useKey && src[i] == key) {
+            continue;
+        }
+        dst[i] = blendPixel(src[i], dst[i], a, tint);
+    }
+}
+
+void SpriteEffects::blendRow(Uint32 *dst, const Uint32 *src, int n, Uint32 key, bool useKey, Uint8 alpha, Uint32 tint) {
+    int i = 0;
+#if defined(SPRITE_SSE2)
+    Uint32 a = alpha + (alpha >> 7);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16((short)a);
+    const __m128i vna = _mm_set1_epi16((short)(256 - a));
+    const __m128i vt = _mm_add_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)tint), zero), _mm_set1_epi16(1));
+    const __m128i vkey = _mm_set1_epi32((int)key);
+    for(; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i slo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), vt), 8);
+        __m128i shi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), vt), 8);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(slo, va), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), vna));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(shi, va), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), vna));
+        __m128i out = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        if(useKey) {
+            // los píxeles con color clave conservan el destino
+            __m128i m = _mm_cmpeq_epi32(s, vkey);
+            out = _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, out));
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+#elif defined(SPRITE_NEON)
+    Uint32 a = alpha + (alpha >> 7);
+    const uint16x8_t va = vdupq_n_u16((uint16_t)a);
+    const uint16x8_t vna = vdupq_n_u16((uint16_t)(256 - a));
+    const uint16x8_t vt = vaddq_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(tint))), vdupq_n_u16(1));
+    const uint32x4_t vkey = vdupq_n_u32(key);
+    for(; i + 4 <= n; i += 4) {
+        uint32x4_t s = vld1q_u32(src + i);
+        uint32x4_t d = vld1q_u32(dst + i);
+        uint8x16_t s8 = vreinterpretq_u8_u32(s);
+        uint8x16_t d8 = vreinterpretq_u8_u32(d);
+        uint16x8_t slo = vshrq_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(s8)), vt), 8);
+        uint16x8_t shi = vshrq_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(s8)), vt), 8);
+        uint16x8_t lo = vmlaq_u16(vmulq_u16(slo, va), vmovl_u8(vget_low_u8(d8)), vna);
+        uint16x8_t hi = vmlaq_u16(vmulq_u16(shi, va), vmovl_u8(vget_high_u8(d8)), vna);
+        uint32x4_t out = vreinterpretq_u32_u8(vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        if(useKey) {
+            out = vbslq_u32(vceqq_u32(s, vkey), d, out);
+        }
+        vst1q_u32(dst + i, out);
+    }
+#endif
+    blendRowScalar(dst + i, src + i, n - i, key, useKey, alpha, tint);
+}
+
+void SpriteEffects::drawBlended(Sprite &sprite, SDL_Surface *dst, int x, int y) {
+    int frame = sprite.getFrame();
+    SDL_Surface *src = sprite.getSurface();
+    if(!sprite.isSprite() || !dst || frame < 0 || frame >= sprite.getMaxFrames()) {
+        return;
+    }
+    SpriteFrame view = sprite.getFrameView(frame);
+    drawBlendedFrame(src, view.rect, sprite.getAlpha(), sprite.getTint(),
+                     (src->flags & SDL_SRCCOLORKEY) != 0, src->format->colorkey, dst, x, y);
+}
+
+void SpriteEffects::drawBlendedFrame(SDL_Surface *src, const SDL_Rect &rect, Uint8 alpha, Uint32 tint,
+                                     bool useKey, Uint32 key, SDL_Surface *dst, int x, int y) {
+    if(alpha == 0 || rect.w == 0 || rect.h == 0) {
+        return;
+    }
+
+    // recorte contra el área de recorte del destino
+    const SDL_Rect &clip = dst->clip_rect;
+    int x0 = SPRITE_MAX(x, (int)clip.x);
+    int y0 = SPRITE_MAX(y, (int)clip.y);
+    int x1 = SPRITE_MIN(x + (int)rect.w, (int)clip.x + (int)clip.w);
+    int y1 = SPRITE_MIN(y + (int)rect.h, (int)clip.y + (int)clip.h);
+    if(x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    bool direct = src->format->BitsPerPixel == 32 && dst->format->BitsPerPixel == 32
+        && src->format->Rmask == dst->format->Rmask
+        && src->format->Gmask == dst->format->Gmask
+        && src->format->Bmask == dst->format->Bmask;
+
+    // con RLE cada lock decodifica la hoja entera y el unlock la vuelve a
+    // codificar: se le quita una vez y se queda sin él
+    if(src->flags & SDL_RLEACCELOK) {
+        SDL_SetColorKey(src, src->flags & SDL_SRCCOLORKEY, src->format->colorkey);
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
+    }
+    if(SDL_MUSTLOCK(dst)) {
+        SDL_LockSurface(dst);
+    }
+    int sx = rect.x + (x0 - x);
+    int sy = rect.y + (y0 - y);
+    pixfmt srcScratch, dstScratch;
+    const pixfmt *srcFmt = pixfmt_get(src->format, &srcScratch);
+    const pixfmt *dstFmt = pixfmt_get(dst->format, &dstScratch);
+    Uint32 rgbTint = pixfmt_unpack_rgb(srcFmt, tint);
+    for(int j = 0; j < y1 - y0; j++) {
+        if(direct) {
+            blendRow((Uint32*)((Uint8*)dst->pixels + (y0 + j) * dst->pitch) + x0,
+                     (const Uint32*)((const Uint8*)src->pixels + (sy + j) * src->pitch) + sx,
+                     x1 - x0, key, useKey, alpha, tint);
+            continue;
+        }
+        // formatos distintos: píxel a píxel a través de RGB
+        Uint32 a = alpha + (alpha >> 7);
+        for(int i = 0; i < x1 - x0; i++) {
+            Uint32 p = getPixel(src, sx + i, sy + j);
+            if(useKey && p == key) {
+                continue;
+            }
+            Uint32 s = pixfmt_unpack_rgb(srcFmt, p);
+            Uint32 d = pixfmt_unpack_rgb(dstFmt, getPixel(dst, x0 + i, y0 + j));
+            Uint32 o = blendPixel(s, d, a, rgbTint);
+            setPixel(dst, x0 + i, y0 + j, pixfmt_pack_rgb(dstFmt, o));
+        }
+    }
+    if(SDL_MUSTLOCK(dst)) {
+        SDL_UnlockSurface(dst);
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+    dirty_rect_add_xywh(dst, x0, y0, x1 - x0, y1 - y0);
+}
+
+/*
+  Expande una fila de índices a través de la tabla de la paleta. Se leen
+  cuatro índices de golpe para saltar rápido los tramos transparentes.
+  */
+template<typename T>
+static void expandRow(T *dst, const Uint8 *src, int n, const Uint32 *lut, int key) {
+    int i = 0;
+    if(key >= 0) {
+        Uint32 key4 = (Uint32)key * 0x01010101u;
+        for(; i + 4 <= n; i += 4) {
+            Uint32 q;
+            memcpy(&q, src + i, 4);
+            if(q == key4) {
+                continue;
+            }
+            for(int k = i; k < i + 4; k++) {
+                if(src[k] != key) {
+                    dst[k] = (T)lut[src[k]];
                 }
             }
         }
+        for(; i < n; i++) {
+            if(src[i] != key) {
+                dst[i] = (T)lut[src[i]];
+            }
+        }
+        return;
     }
-    sprite.setWidth( rotated->w/sprite.getMaxFrames() );
-    sprite.setHeight( rotated->h );
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        SDL_SetColorKey(rotated, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite.getSurface()->format->colorkey );
+    for(; i < n; i++) {
+        dst[i] = (T)lut[src[i]];
     }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_UnlockSurface(sprite.getSurface());
+}
+
+void SpriteEffects::drawIndexed(Sprite &sprite, SDL_Surface *dst, int x, int y) {
+    int frame = sprite.getFrame();
+    SDL_Surface *src = sprite.getSurface();
+    if(!sprite.isIndexed() || !dst || frame < 0 || frame >= sprite.getMaxFrames()) {
+        return;
     }
-    SDL_FreeSurface(sprite.getSurface());
-    sprite.setSurface(rotated);
+    SpriteFrame view = sprite.getFrameView(frame);
+    Uint8 alpha = sprite.getAlpha();
+    if(alpha == 0 || view.rect.w == 0 || view.rect.h == 0) {
+        return;
+    }
+
+    int dbpp = dst->format->BytesPerPixel;
+    if(dbpp != 2 && dbpp != 4) {
+        // otros destinos: SDL con la paleta de la hoja
+        SDL_Rect srcrect = view.rect;
+        SDL_Rect dstrect;
+        dstrect.x = x;
+        dstrect.y = y;
+        SDL_BlitSurface(src, &srcrect, dst, &dstrect);
+        dirty_rect_add(dst, &dstrect);
+        return;
+    }
+
+    int key = (src->flags & SDL_SRCCOLORKEY) ? (int)(src->format->colorkey & 0xff) : -1;
+    drawIndexedFrame(src, view.rect, alpha, key, sprite.getPaletteLUT(dst->format), dst, x, y);
 }
 
+void SpriteEffects::drawIndexedFrame(SDL_Surface *src, const SDL_Rect &rect, Uint8 alpha, int key,
+                                     const Uint32 *lut, SDL_Surface *dst, int x, int y) {
+    int dbpp = dst->format->BytesPerPixel;
 
+    // recorte contra el área de recorte del destino
+    const SDL_Rect &clip = dst->clip_rect;
+    int x0 = SPRITE_MAX(x, (int)clip.x);
+    int y0 = SPRITE_MAX(y, (int)clip.y);
+    int x1 = SPRITE_MIN(x + (int)rect.w, (int)clip.x + (int)clip.w);
+    int y1 = SPRITE_MIN(y + (int)rect.h, (int)clip.y + (int)clip.h);
+    if(x0 >= x1 || y0 >= y1) {
+        return;
+    }
 
-void SpriteEffects::fade(Sprite &sprite, float fade) {
-    return;
+    Uint32 a = alpha + (alpha >> 7);
+    int sx = rect.x + (x0 - x);
+    int sy = rect.y + (y0 - y);
+    int n = x1 - x0;
+    pixfmt dstScratch;
+    const pixfmt *dstFmt = pixfmt_get(dst->format, &dstScratch);
+
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
+    }
+    if(SDL_MUSTLOCK(dst)) {
+        SDL_LockSurface(dst);
+    }
+    for(int j = 0; j < y1 - y0; j++) {
+        const Uint8 *s = (const Uint8*)src->pixels + (sy + j) * src->pitch + sx;
+        Uint8 *d = (Uint8*)dst->pixels + (y0 + j) * dst->pitch + x0 * dbpp;
+        if(alpha == 255) {
+            if(dbpp == 4) {
+                expandRow<Uint32>((Uint32*)d, s, n, lut, key);
+            } else {
+                expandRow<Uint16>((Uint16*)d, s, n, lut, key);
+            }
+            continue;
+        }
+        for(int i = 0; i < n; i++) {
+            if(s[i] == key) {
+                continue;
+            }
+            if(dbpp == 4) {
+                ((Uint32*)d)[i] = blendPixel(lut[s[i]], ((Uint32*)d)[i], a, 0xffffffff);
+            } else {
+                // 16 bits: se mezcla en RGB y se vuelve a empaquetar
+                Uint32 o = blendPixel(pixfmt_unpack_rgb(dstFmt, lut[s[i]]),
+                                      pixfmt_unpack_rgb(dstFmt, ((Uint16*)d)[i]), a, 0xffffffff);
+                ((Uint16*)d)[i] = (Uint16)pixfmt_pack_rgb(dstFmt, o);
+            }
+        }
+    }
+    if(SDL_MUSTLOCK(dst)) {
+        SDL_UnlockSurface(dst);
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+    dirty_rect_add_xywh(dst, x0, y0, n, y1 - y0);
 }
 
 void SpriteEffects::reverseAnimation(Sprite &sprite) {
@@ -711,35 +1629,32 @@ void SpriteEffects::reverseAnimation(Sprite &sprite) {
          //std::cout << "Failed to reverse animation, Sprite not initialized!" << std::endl;
          return;
     }
-    SDL_Surface* reversed = NULL;
+    SDL_Surface* src = sprite.getSurface();
     // create a new surface
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        reversed = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w, sprite.getSurface()->h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, sprite.getSurface()->format->Amask );
-    } else {
-        reversed = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w, sprite.getSurface()->h, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, 0);
+    SDL_Surface* reversed = createLike(src, src->w, src->h);
+    if(!reversed) {
+        return;
     }
     // check to see if the surface must be locked
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_LockSurface(sprite.getSurface());
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
     }
 
-    for(int f = 0; f < sprite.getMaxFrames(); f++) {
-        for(int y = 0; y < sprite.getSurface()->h; y++) {
-            for(int x = 0; x < sprite.getWidth(); x++) {
-                setPixel(reversed, (sprite.getMaxFrames() - f - 1)*sprite.getWidth() + x , y, sprite.getPixel(f*sprite.getWidth()+x,y));
-            }
+    // los frames se mueven enteros: una copia por frame y fila
+    int frames = sprite.getMaxFrames();
+    int span = sprite.getWidth() * src->format->BytesPerPixel;
+    for(int y = 0; y < src->h; y++) {
+        const Uint8 *s = (const Uint8*)src->pixels + y * src->pitch;
+        Uint8 *d = (Uint8*)reversed->pixels + y * reversed->pitch;
+        for(int f = 0; f < frames; f++) {
+            memcpy(d + (frames - f - 1) * span, s + f * span, span);
         }
     }
     //Copy color key
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        SDL_SetColorKey(reversed, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite.getSurface()->format->colorkey );
-    }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_UnlockSurface(sprite.getSurface());
+    copyColorKey(src, reversed);
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
     }
-    SDL_FreeSurface(sprite.getSurface());
     sprite.setSurface(reversed);
 }
 
@@ -763,44 +1678,39 @@ void SpriteEffects::stretch(Sprite &sprite, float stretchX, float stretchY) {
          //std::cout << "Failed to zoom, Sprite not initialized!"<< std::endl;
          return;
      }
-    SDL_Surface* zoomed;
     if(stretchX < 1 || stretchY < 1) {
         //std::cout << "Failed to zoom, value must be greater than zero!"<< std::endl;
         return;
     }
     stretchX /= 100;
     stretchY /= 100;
+    SDL_Surface* src = sprite.getSurface();
     // create a new surface
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY) {
-        zoomed = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w*stretchX, sprite.getSurface()->h*stretchY, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, sprite.getSurface()->format->Amask  );
-    } else {
-        zoomed = SDL_CreateRGBSurface(SDL_SWSURFACE, sprite.getSurface()->w*stretchX, sprite.getSurface()->h*stretchY, sprite.getSurface()->format->BitsPerPixel,
-        sprite.getSurface()->format->Rmask, sprite.getSurface()->format->Gmask, sprite.getSurface()->format->Bmask, 0);
+    SDL_Surface* zoomed = createLike(src, src->w*stretchX, src->h*stretchY);
+    if(!zoomed) {
+        return;
     }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_LockSurface(sprite.getSurface());
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
     }
-    int zoomedWidth = zoomed->w/sprite.getMaxFrames();
-
-    for(int y = 0; y < zoomed->h; y++) {
-        for(int x = 0; x < zoomedWidth; x++) {
-            // iterate over each animation as opposed to the whole sprite, to ensure that each animation is resized properly
-            for(int i = 0; i < sprite.getMaxFrames(); i++) {
-                setPixel(zoomed, (zoomedWidth * i) + x, y, sprite.getPixel((sprite.getWidth() * i) + (int)(x/stretchX),(int)(y/stretchY) ));
-            }
+    int frames = sprite.getMaxFrames();
+    int zoomedWidth = zoomed->w/frames;
+
+    if(zoomedWidth > 0) {
+        switch(src->format->BytesPerPixel) {
+            case 1: stretchSurface<1>(src, zoomed, sprite.getWidth(), frames, stretchX, stretchY); break;
+            case 2: stretchSurface<2>(src, zoomed, sprite.getWidth(), frames, stretchX, stretchY); break;
+            case 3: stretchSurface<3>(src, zoomed, sprite.getWidth(), frames, stretchX, stretchY); break;
+            case 4: stretchSurface<4>(src, zoomed, sprite.getWidth(), frames, stretchX, stretchY); break;
         }
     }
 
     sprite.setWidth( zoomedWidth );
     sprite.setHeight( zoomed->h );
-    if(sprite.getSurface()->flags & SDL_SRCCOLORKEY ) {
-        SDL_SetColorKey(zoomed, SDL_RLEACCEL|SDL_SRCCOLORKEY, sprite.getSurface()->format->colorkey );
-    }
-    if(SDL_MUSTLOCK(sprite.getSurface())) {
-        SDL_UnlockSurface(sprite.getSurface());
+    copyColorKey(src, zoomed);
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
     }
-    SDL_FreeSurface(sprite.getSurface());
     sprite.setSurface(zoomed);
 }
 
@@ -0,0 +1,279 @@
+#include <SpriteBatch.h>
+#include <algorithm>
+#include <cstring>
+#include <dirty_rect.h>
+#include <perf.h>
+
+
+SpriteBatch::SpriteBatch() : scratch(NULL) {
+}
+
+SpriteBatch::~SpriteBatch() {
+    if(scratch) {
+        SDL_FreeSurface(scratch);
+    }
+}
+
+void SpriteBatch::reserve(int n) {
+    commands.reserve(n);
+}
+
+void SpriteBatch::begin() {
+    commands.clear();
+}
+
+int SpriteBatch::size() const {
+    return (int)commands.size();
+}
+
+void SpriteBatch::add(Sprite &sprite, int x, int y, int flags, int layer) {
+    addFrame(sprite, sprite.getFrame(), x, y, flags, layer);
+}
+
+void SpriteBatch::addFrame(Sprite &sprite, int frame, int x, int y, int flags, int layer) {
+    if(!sprite.isSprite()) {
+        return;
+    }
+    SpriteFrame view = sprite.getFrameView(frame);
+    if(!view.surface || view.rect.w == 0 || view.rect.h == 0) {
+        return;
+    }
+
+    Command cmd;
+    cmd.surface = view.surface;
+    cmd.rect = view.rect;
+    cmd.x = x;
+    cmd.y = y;
+    cmd.flags = flags;
+    cmd.layer = layer;
+    cmd.order = (Uint32)commands.size();
+    commands.push_back(cmd);
+}
+
+bool SpriteBatch::compare(const Command &a, const Command &b) {
+    if(a.layer != b.layer) {
+        return a.layer < b.layer;
+    }
+    if(a.surface != b.surface) {
+        return a.surface < b.surface;
+    }
+    return a.order < b.order;
+}
+
+// quita el RLE una vez: con él cada lock decodifica la hoja entera
+static void dropRLE(SDL_Surface *src) {
+    if(src->flags & SDL_RLEACCELOK) {
+        SDL_SetColorKey(src, src->flags & SDL_SRCCOLORKEY, src->format->colorkey);
+    }
+}
+
+bool SpriteBatch::canSpanBlit(SDL_Surface *src, SDL_Surface *dst) {
+    if(src->flags & SDL_SRCALPHA) {
+        return false;
+    }
+    return src->format->BitsPerPixel == 32 && dst->format->BitsPerPixel == 32
+        && src->format->Amask == 0
+        && src->format->Rmask == dst->format->Rmask
+        && src->format->Gmask == dst->format->Gmask
+        && src->format->Bmask == dst->format->Bmask;
+}
+
+bool SpriteBatch::spanBlit(const Command &cmd, SDL_Surface *dst, SDL_Rect *drawn) {
+    SDL_Surface *src = cmd.surface;
+    const SDL_Rect &clip = dst->clip_rect;
+
+    // recorte contra el área de recorte del destino
+    int x0 = SPRITE_MAX(cmd.x, (int)clip.x);
+    int y0 = SPRITE_MAX(cmd.y, (int)clip.y);
+    int x1 = SPRITE_MIN(cmd.x + (int)cmd.rect.w, (int)clip.x + (int)clip.w);
+    int y1 = SPRITE_MIN(cmd.y + (int)cmd.rect.h, (int)clip.y + (int)clip.h);
+    if(x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+
+    bool usekey = (src->flags & SDL_SRCCOLORKEY) != 0;
+    Uint32 key = src->format->colorkey;
+    bool flipx = (cmd.flags & FLIP_HORIZONTAL) != 0;
+    bool flipy = (cmd.flags & FLIP_VERTICAL) != 0;
+    int n = x1 - x0;
+
+    for(int y = y0; y < y1; y++) {
+        int sy = flipy ? cmd.rect.y + cmd.rect.h - 1 - (y - cmd.y) : cmd.rect.y + (y - cmd.y);
+        const Uint32 *srow = (const Uint32 *)((Uint8 *)src->pixels + sy * src->pitch);
+        Uint32 *d = (Uint32 *)((Uint8 *)dst->pixels + y * dst->pitch) + x0;
+
+        if(flipx) {
+            const Uint32 *s = srow + cmd.rect.x + cmd.rect.w - 1 - (x0 - cmd.x);
+            for(int i = 0; i < n; i++) {
+                Uint32 p = *(s - i);
+                if(!usekey || p != key) {
+                    d[i] = p;
+                }
+            }
+            continue;
+        }
+
+        const Uint32 *s = srow + cmd.rect.x + (x0 - cmd.x);
+        if(!usekey) {
+            memcpy(d, s, n * 4);
+            continue;
+        }
+        int i = 0;
+        while(i < n) {
+            // salta el tramo transparente y copia el opaco entero
+            while(i < n && s[i] == key) {
+                i++;
+            }
+            int start = i;
+            while(i < n && s[i] != key) {
+                i++;
+            }
+            if(i > start) {
+                memcpy(d + start, s + start, (i - start) * 4);
+            }
+        }
+    }
+
+    drawn->x = (Sint16)x0;
+    drawn->y = (Sint16)y0;
+    drawn->w = (Uint16)(x1 - x0);
+    drawn->h = (Uint16)(y1 - y0);
+    return true;
+}
+
+bool SpriteBatch::flippedBlit(const Command &cmd, SDL_Surface *dst, SDL_Rect *drawn) {
+    SDL_Surface *src = cmd.surface;
+    SDL_PixelFormat *f = src->format;
+    int w = cmd.rect.w, h = cmd.rect.h, bpp = f->BytesPerPixel;
+
+    // la superficie auxiliar se reutiliza mientras el formato y el tamaño sirvan
+    if(scratch && (scratch->w < w || scratch->h < h || scratch->format->BitsPerPixel != f->BitsPerPixel
+            || scratch->format->Rmask != f->Rmask || scratch->format->Gmask != f->Gmask
+            || scratch->format->Bmask != f->Bmask || scratch->format->Amask != f->Amask)) {
+        w = SPRITE_MAX(w, scratch->w);
+        h = SPRITE_MAX(h, scratch->h);
+        SDL_FreeSurface(scratch);
+        scratch = NULL;
+    }
+    if(!scratch) {
+        scratch = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, f->BitsPerPixel,
+            f->Rmask, f->Gmask, f->Bmask, f->Amask);
+        if(!scratch) {
+            return false;
+        }
+        PERF_COUNT(PERF_SURFACES, 1);
+    }
+    w = cmd.rect.w;
+    h = cmd.rect.h;
+    if(f->palette) {
+        SDL_SetColors(scratch, f->palette->colors, 0, f->palette->ncolors);
+    }
+    SDL_SetColorKey(scratch, src->flags & SDL_SRCCOLORKEY, f->colorkey);
+    SDL_SetAlpha(scratch, src->flags & SDL_SRCALPHA, f->alpha);
+
+    dropRLE(src);
+    if(SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
+    }
+    bool flipx = (cmd.flags & FLIP_HORIZONTAL) != 0;
+    bool flipy = (cmd.flags & FLIP_VERTICAL) != 0;
+    for(int y = 0; y < h; y++) {
+        int sy = flipy ? cmd.rect.y + h - 1 - y : cmd.rect.y + y;
+        const Uint8 *s = (const Uint8 *)src->pixels + sy * src->pitch + cmd.rect.x * bpp;
+        Uint8 *d = (Uint8 *)scratch->pixels + y * scratch->pitch;
+        if(!flipx) {
+            memcpy(d, s, w * bpp);
+            continue;
+        }
+        for(int x = 0; x < w; x++) {
+            memcpy(d + x * bpp, s + (w - 1 - x) * bpp, bpp);
+        }
+    }
+    if(SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+
+    SDL_Rect srcRect;
+    srcRect.x = 0;
+    srcRect.y = 0;
+    srcRect.w = (Uint16)w;
+    srcRect.h = (Uint16)h;
+    drawn->x = (Sint16)cmd.x;
+    drawn->y = (Sint16)cmd.y;
+    return SDL_BlitSurface(scratch, &srcRect, dst, drawn) == 0;
+}
+
+int SpriteBatch::end(SDL_Surface *dst) {
+    if(!dst || commands.empty()) {
+        commands.clear();
+        return 0;
+    }
+
+    std::sort(commands.begin(), commands.end(), compare);
+
+    bool dstLocked = SDL_LockSurface(dst) == 0;
+    SDL_Surface *lockedSrc = NULL;
+    bool spanOk = false;
+    int drawnCount = 0;
+
+    for(size_t i = 0; i < commands.size(); i++) {
+        const Command &cmd = commands[i];
+
+        // cambio de hoja: un bloqueo por hoja, no por sprite
+        if(cmd.surface != lockedSrc) {
+            if(lockedSrc) {
+                SDL_UnlockSurface(lockedSrc);
+                lockedSrc = NULL;
+            }
+            spanOk = dstLocked && canSpanBlit(cmd.surface, dst);
+            if(spanOk) {
+                dropRLE(cmd.surface);
+                SDL_LockSurface(cmd.surface);
+                lockedSrc = cmd.surface;
+            }
+        }
+
+        SDL_Rect drawn;
+        if(spanOk) {
+            if(spanBlit(cmd, dst, &drawn)) {
+                dirty_rect_add(dst, &drawn);
+                PERF_COUNT(PERF_PIXELS, drawn.w * drawn.h);
+                drawnCount++;
+            }
+            continue;
+        }
+
+        // ruta de SDL, con el destino desbloqueado; el volteo pasa por scratch
+        if(dstLocked) {
+            SDL_UnlockSurface(dst);
+        }
+        bool ok;
+        if(cmd.flags & (FLIP_HORIZONTAL | FLIP_VERTICAL)) {
+            ok = flippedBlit(cmd, dst, &drawn);
+        } else {
+            SDL_Rect srcRect = cmd.rect;
+            drawn.x = (Sint16)cmd.x;
+            drawn.y = (Sint16)cmd.y;
+            ok = SDL_BlitSurface(cmd.surface, &srcRect, dst, &drawn) == 0;
+        }
+        if(ok) {
+            dirty_rect_add(dst, &drawn);
+            PERF_COUNT(PERF_PIXELS, drawn.w * drawn.h);
+            drawnCount++;
+        }
+        if(dstLocked) {
+            dstLocked = SDL_LockSurface(dst) == 0;
+        }
+    }
+
+    if(lockedSrc) {
+        SDL_UnlockSurface(lockedSrc);
+    }
+    if(dstLocked) {
+        SDL_UnlockSurface(dst);
+    }
+
+    PERF_COUNT(PERF_BLITS, drawnCount);
+    commands.clear();
+    return drawnCount;
+}
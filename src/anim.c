@@ -0,0 +1,242 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <anim.h>
+
+
+#define ANIM_USED	1
+#define ANIM_RUN	2
+#define ANIM_LOOP	4
+#define ANIM_TICK	8		// anim_tick() en este frame
+
+// estado de todas las animaciones, un arreglo por campo
+static int *anim_frames = NULL;		// frame actual
+static int *anim_total = NULL;		// número de frames
+static Uint32 *anim_ms = NULL;		// milisegundos por frame
+static Uint32 *anim_acc = NULL;		// tiempo acumulado
+static s8 *anim_dir = NULL;		// 1 o -1
+static u8 *anim_flags = NULL;		// ANIM_*
+
+static int anim_cap = 0;		// ranuras reservadas
+static int anim_used = 0;		// ranuras hasta la última ocupada
+static int anim_live = 0;		// animaciones activas
+static int *anim_free = NULL;		// ranuras libres
+static int anim_nfree = 0;
+
+static Uint32 anim_now = 0;
+static int anim_clock = 0;		// ya hay una muestra del reloj
+
+
+static int anim_valid(int h){
+	return h >= 0 && h < anim_used && (anim_flags[h] & ANIM_USED);
+}
+
+static int anim_grow(){
+	int cap = anim_cap ? anim_cap * 2 : 64;
+	void *p;
+
+	// si algún realloc falla los arreglos ya crecidos siguen siendo válidos
+#define GROW(a) \
+	if (!(p = realloc(a, cap * sizeof(*(a))))) return 0; \
+	a = p;
+
+	GROW(anim_frames);
+	GROW(anim_total);
+	GROW(anim_ms);
+	GROW(anim_acc);
+	GROW(anim_dir);
+	GROW(anim_flags);
+	GROW(anim_free);
+#undef GROW
+
+	anim_cap = cap;
+	return 1;
+}
+
+
+int anim_create(int frames, Uint32 speed, int running){
+	int h;
+
+	if (anim_nfree > 0) {
+		h = anim_free[--anim_nfree];
+	} else {
+		if (anim_used == anim_cap && !anim_grow())
+			return ANIM_INVALID;
+		h = anim_used++;
+	}
+
+	anim_frames[h] = 0;
+	anim_total[h] = frames > 0 ? frames : 1;
+	anim_ms[h] = speed;
+	anim_acc[h] = 0;
+	anim_dir[h] = 1;
+	anim_flags[h] = ANIM_USED | ANIM_LOOP | (running ? ANIM_RUN : 0);
+	anim_live++;
+	return h;
+}
+
+void anim_destroy(int h){
+	if (!anim_valid(h))
+		return;
+
+	anim_flags[h] = 0;
+	anim_free[anim_nfree++] = h;
+	anim_live--;
+}
+
+void anim_update(){
+	anim_update_ticks(SDL_GetTicks());
+}
+
+void anim_update_ticks(Uint32 now){
+	Uint32 dt, steps, per;
+	int i, n, f, d;
+
+	dt = anim_clock ? now - anim_now : 0;
+	anim_now = now;
+	anim_clock = 1;
+	if (dt == 0)
+		return;
+
+	for (i = 0; i < anim_used; i++) {
+		// solo avanzan las que el juego pidió en este frame, como el antiguo animate()
+		if ((anim_flags[i] & (ANIM_RUN | ANIM_TICK)) != (ANIM_RUN | ANIM_TICK)) {
+			anim_flags[i] &= ~ANIM_TICK;
+			continue;
+		}
+		anim_flags[i] &= ~ANIM_TICK;
+
+		per = anim_ms[i] ? anim_ms[i] : 1;
+		anim_acc[i] += dt;
+		if (anim_acc[i] < per)
+			continue;
+
+		// lo normal es avanzar un solo frame; la división solo tras una pausa
+		if (anim_acc[i] < 2 * per) {
+			steps = 1;
+			anim_acc[i] -= per;
+		} else {
+			steps = anim_acc[i] / per;
+			anim_acc[i] -= steps * per;
+		}
+
+		n = anim_total[i];
+		f = anim_frames[i];
+		if (anim_flags[i] & ANIM_LOOP) {
+			f += steps;
+			anim_frames[i] = f < n ? f : (int)(f % n);
+			anim_dir[i] = 1;
+			continue;
+		}
+
+		// ida y vuelta: los extremos se repiten, el periodo es 2n
+		steps %= 2 * n;
+		d = anim_dir[i];
+		while (steps--) {
+			f += d;
+			if (f >= n) {
+				d = -1;
+				f = n - 1;
+			} else if (f < 0) {
+				d = 1;
+				f = 0;
+			}
+		}
+		anim_frames[i] = f;
+		anim_dir[i] = d;
+	}
+}
+
+void anim_tick(int h){
+	if (anim_valid(h))
+		anim_flags[h] |= ANIM_TICK;
+}
+
+Uint32 anim_time(){
+	return anim_now;
+}
+
+int anim_frame(int h){
+	return anim_valid(h) ? anim_frames[h] : 0;
+}
+
+void anim_set_frame(int h, int frame){
+	if (!anim_valid(h))
+		return;
+
+	if (frame < 0)
+		frame = 0;
+	if (frame >= anim_total[h])
+		frame = anim_total[h] - 1;
+	anim_frames[h] = frame;
+	anim_acc[h] = 0;
+}
+
+int anim_direction(int h){
+	return anim_valid(h) ? anim_dir[h] : 0;
+}
+
+void anim_set_frames(int h, int frames){
+	if (!anim_valid(h))
+		return;
+
+	anim_total[h] = frames > 0 ? frames : 1;
+	if (anim_frames[h] >= anim_total[h])
+		anim_frames[h] = 0;
+}
+
+Uint32 anim_speed(int h){
+	return anim_valid(h) ? anim_ms[h] : 0;
+}
+
+void anim_set_speed(int h, Uint32 speed){
+	if (anim_valid(h))
+		anim_ms[h] = speed;
+}
+
+void anim_set_loop(int h, int loop){
+	if (!anim_valid(h))
+		return;
+
+	if (loop)
+		anim_flags[h] |= ANIM_LOOP;
+	else
+		anim_flags[h] &= ~ANIM_LOOP;
+}
+
+void anim_set_running(int h, int running){
+	if (!anim_valid(h))
+		return;
+
+	if (running)
+		anim_flags[h] |= ANIM_RUN;
+	else
+		anim_flags[h] &= ~ANIM_RUN;
+}
+
+int anim_running(int h){
+	return anim_valid(h) && (anim_flags[h] & ANIM_RUN);
+}
+
+void anim_restart(int h){
+	if (!anim_valid(h))
+		return;
+
+	anim_frames[h] = 0;
+	anim_dir[h] = 1;
+	anim_acc[h] = 0;
+}
+
+int anim_count(){
+	return anim_live;
+}
@@ -0,0 +1,151 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <SDL_gfxPrimitives.h>
+#include <cmdlist.h>
+
+
+#define ARENA_CHUNK 16384
+
+#define MIN2(a, b) ((a) < (b) ? (a) : (b))
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+
+
+void *cmdlist_grow(void *items, int *cap, int need, int size){
+	int n = *cap ? *cap : 64;
+	void *p;
+
+	if (need <= *cap)
+		return items;
+	while (n < need)
+		n *= 2;
+	if (!(p = realloc(items, (size_t)n * size)))
+		return NULL;
+	*cap = n;
+	return p;
+}
+
+int cmdlist_clip(const SDL_Surface *dst, int *x1, int *y1, int *x2, int *y2){
+	const SDL_Rect *clip = &dst->clip_rect;
+
+	if (*x1 < clip->x) *x1 = clip->x;
+	if (*y1 < clip->y) *y1 = clip->y;
+	if (*x2 > clip->x + clip->w) *x2 = clip->x + clip->w;
+	if (*y2 > clip->y + clip->h) *y2 = clip->y + clip->h;
+	return *x1 < *x2 && *y1 < *y2;
+}
+
+int cmdlist_text(cmdlist *l, const char *text){
+	int len = (int)strlen(text) + 1, at = l->text_len;
+	char *p;
+
+	if (!(p = (char*)cmdlist_grow(l->text, &l->text_cap, l->text_len + len, 1)))
+		return -1;
+	l->text = p;
+	memcpy(l->text + l->text_len, text, len);
+	l->text_len += len;
+	return at;
+}
+
+int cmdlist_keep(cmdlist *l, SDL_Surface *s){
+	cmdlist_pin *p;
+
+	if (!(p = (cmdlist_pin*)cmdlist_grow(l->pins, &l->pin_cap, l->pin_count + 1, sizeof(cmdlist_pin))))
+		return -1;
+	l->pins = p;
+	s->refcount++;
+	p[l->pin_count].surf = s;
+	p[l->pin_count].rle = 0;
+	return l->pin_count++;
+}
+
+void *cmdlist_alloc(cmdlist *l, int size){
+	u8 **q;
+	void *p;
+
+	size = (size + 7) & ~7;
+	if (size <= 0 || size > ARENA_CHUNK)
+		return NULL;
+
+	if (l->chunk_cur < l->chunk_count && l->chunk_used + size > ARENA_CHUNK) {
+		l->chunk_cur++;
+		l->chunk_used = 0;
+	}
+	if (l->chunk_cur == l->chunk_count) {
+		if (!(q = (u8**)cmdlist_grow(l->chunks, &l->chunk_cap, l->chunk_count + 1, sizeof(u8*))))
+			return NULL;
+		l->chunks = q;
+		if (!(l->chunks[l->chunk_count] = (u8*)malloc(ARENA_CHUNK)))
+			return NULL;
+		l->chunk_count++;
+		l->chunk_used = 0;
+	}
+
+	p = l->chunks[l->chunk_cur] + l->chunk_used;
+	l->chunk_used += size;
+	return p;
+}
+
+void cmdlist_reset(cmdlist *l){
+	SDL_Surface *s;
+	int i;
+
+	// las hojas recuperan el RLE (SDL las codifica en su próximo blit) y las
+	// que se liberaron mientras se grababa se liberan ahora
+	for (i = 0; i < l->pin_count; i++) {
+		s = l->pins[i].surf;
+		if (l->pins[i].rle && (s->flags & SDL_SRCCOLORKEY) && !(s->flags & SDL_RLEACCELOK))
+			SDL_SetColorKey(s, SDL_SRCCOLORKEY | SDL_RLEACCEL, s->format->colorkey);
+		SDL_FreeSurface(s);
+	}
+	l->pin_count = 0;
+	l->text_len = 0;
+	l->chunk_cur = 0;
+	l->chunk_used = 0;
+}
+
+
+void cmdlist_prim_bounds(int kind, int x1, int y1, int x2, int y2, int *bx1, int *by1, int *bx2, int *by2){
+	if (kind == CMDLIST_CIRCLE || kind == CMDLIST_FILLED_CIRCLE) {
+		*bx1 = x1 - x2;
+		*by1 = y1 - x2;
+		*bx2 = x1 + x2 + 1;
+		*by2 = y1 + x2 + 1;
+		return;
+	}
+	*bx1 = MIN2(x1, x2);
+	*by1 = MIN2(y1, y2);
+	*bx2 = MAX2(x1, x2) + 1;
+	*by2 = MAX2(y1, y2) + 1;
+}
+
+void cmdlist_prim_draw(SDL_Surface *dst, int kind, int x1, int y1, int x2, int y2, int ox, int oy, u32 rgba){
+	switch (kind) {
+	case CMDLIST_LINE:
+		lineColor(dst, x1 - ox, y1 - oy, x2 - ox, y2 - oy, rgba);
+		break;
+	case CMDLIST_RECT:
+		rectangleColor(dst, x1 - ox, y1 - oy, x2 - ox, y2 - oy, rgba);
+		break;
+	case CMDLIST_BOX:
+		boxColor(dst, x1 - ox, y1 - oy, x2 - ox, y2 - oy, rgba);
+		break;
+	case CMDLIST_CIRCLE:
+		circleColor(dst, x1 - ox, y1 - oy, x2, rgba);
+		break;
+	case CMDLIST_FILLED_CIRCLE:
+		filledCircleColor(dst, x1 - ox, y1 - oy, x2, rgba);
+		break;
+	}
+}
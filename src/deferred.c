@@ -0,0 +1,605 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <dirty_rect.h>
+#include <job_pool.h>
+#include <fill.h>
+#include <font.h>
+#include <cmdlist.h>
+#include <deferred.h>
+#include <perf.h>
+
+
+enum {
+	CMD_BLIT,			// copia propia, en paralelo
+	CMD_SDL_BLIT,		// SDL_BlitSurface en el hilo principal (corta el lote)
+	CMD_FILL,
+	CMD_TEXT,
+	CMD_PRIM,			// primitiva CMDLIST_* en p3
+	CMD_CALL
+};
+
+// estado de la superficie tomado al grabar (junto a DEFERRED_FLIP_*)
+#define BLIT_KEY		4
+#define BLIT_PERPIXEL	8
+
+typedef struct {
+	int type;
+	int x1, y1, x2, y2;		// caja afectada [x1,x2) x [y1,y2), ya recortada
+	SDL_Surface *src;
+	SDL_Rect srect;
+	int x, y;				// destino del blit/texto, primer punto o centro
+	int p1, p2, p3;			// segundo punto o radio y tipo; celda y longitud del texto
+	int flags;				// DEFERRED_FLIP_* y BLIT_*
+	Uint8 alpha;			// ya multiplicado por el alpha de la superficie
+	u32 key;				// color key sin el canal alpha
+	u32 color;				// color del relleno, texto o primitiva; tinte del blit
+	int text;				// desplazamiento en rec.text
+	deferred_func fn;
+	void *ctx;
+} deferred_cmd;
+
+typedef struct {
+	int *cmds;				// órdenes que tocan el tile, en orden de grabación
+	int count, cap;
+	SDL_Surface *view;		// superficie sobre una zona del tile (ver tile_view)
+	int x, y, w, h;
+} deferred_tile;
+
+
+static SDL_Surface *target = NULL;
+static int recording = 0;
+
+static deferred_cmd *cmds = NULL;
+static int cmd_count = 0, cmd_cap = 0;
+static cmdlist rec;			// textos, superficies retenidas y contextos
+
+// tiles para la geometría actual del destino
+static deferred_tile *tiles = NULL;
+static int *order = NULL;
+static int tiles_x = 0, tiles_y = 0;
+static int geo_w, geo_h, geo_pitch, geo_bpp;
+static Uint32 geo_rmask, geo_gmask, geo_bmask;
+
+
+#define ROW32(s, y) ((u32*)((u8*)(s)->pixels + (y) * (s)->pitch))
+#define MIN2(a, b) ((a) < (b) ? (a) : (b))
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+
+
+static void free_tiles(){
+	int i;
+
+	for (i = 0; i < tiles_x * tiles_y; i++) {
+		free(tiles[i].cmds);
+		if (tiles[i].view)
+			SDL_FreeSurface(tiles[i].view);
+	}
+	free(tiles);
+	free(order);
+	tiles = NULL;
+	order = NULL;
+	tiles_x = tiles_y = 0;
+}
+
+static int setup_tiles(SDL_Surface *dst){
+	SDL_PixelFormat *f = dst->format;
+	int tx, ty, n;
+	deferred_tile *t;
+
+	if (tiles && geo_w == dst->w && geo_h == dst->h && geo_pitch == dst->pitch &&
+			geo_bpp == f->BitsPerPixel && geo_rmask == f->Rmask &&
+			geo_gmask == f->Gmask && geo_bmask == f->Bmask)
+		return 1;
+
+	free_tiles();
+	tiles_x = (dst->w + DEFERRED_TILE - 1) / DEFERRED_TILE;
+	tiles_y = (dst->h + DEFERRED_TILE - 1) / DEFERRED_TILE;
+	n = tiles_x * tiles_y;
+	tiles = (deferred_tile*)calloc(n, sizeof(deferred_tile));
+	order = (int*)malloc(n * sizeof(int));
+	if (!tiles || !order) {
+		free(tiles);
+		free(order);
+		tiles = NULL;
+		order = NULL;
+		tiles_x = tiles_y = 0;
+		return 0;
+	}
+
+	for (ty = 0; ty < tiles_y; ty++) {
+		for (tx = 0; tx < tiles_x; tx++) {
+			t = &tiles[ty * tiles_x + tx];
+			t->x = tx * DEFERRED_TILE;
+			t->y = ty * DEFERRED_TILE;
+			t->w = dst->w - t->x < DEFERRED_TILE ? dst->w - t->x : DEFERRED_TILE;
+			t->h = dst->h - t->y < DEFERRED_TILE ? dst->h - t->y : DEFERRED_TILE;
+			// la zona y los píxeles se fijan en cada orden: el destino puede moverse al bloquearlo
+			t->view = SDL_CreateRGBSurfaceFrom(dst->pixels, t->w, t->h, f->BitsPerPixel,
+				dst->pitch, f->Rmask, f->Gmask, f->Bmask, f->Amask);
+			if (!t->view) {
+				free_tiles();
+				return 0;
+			}
+		}
+	}
+
+	geo_w = dst->w;
+	geo_h = dst->h;
+	geo_pitch = dst->pitch;
+	geo_bpp = f->BitsPerPixel;
+	geo_rmask = f->Rmask;
+	geo_gmask = f->Gmask;
+	geo_bmask = f->Bmask;
+	return 1;
+}
+
+
+int deferred_begin(SDL_Surface *dst){
+	if (recording)
+		deferred_end();
+	if (!dst || !dst->format || !setup_tiles(dst))
+		return -1;
+
+	target = dst;
+	recording = 1;
+	cmd_count = 0;
+	return 0;
+}
+
+int deferred_active(){
+	return recording;
+}
+
+SDL_Surface *deferred_target(){
+	return recording ? target : NULL;
+}
+
+int deferred_keep(SDL_Surface *s){
+	if (!recording || !s)
+		return -1;
+	return cmdlist_keep(&rec, s) < 0 ? -1 : 0;
+}
+
+void *deferred_alloc(int size){
+	return recording ? cmdlist_alloc(&rec, size) : NULL;
+}
+
+
+/*
+  Reserva una orden con su caja recortada contra el área de recorte del
+  destino. Devuelve NULL si la orden no se ve o no hay memoria.
+  */
+static deferred_cmd *new_cmd(int type, int x1, int y1, int x2, int y2){
+	deferred_cmd *c;
+
+	if (!recording || !cmdlist_clip(target, &x1, &y1, &x2, &y2))
+		return NULL;
+	if (!(c = (deferred_cmd*)cmdlist_grow(cmds, &cmd_cap, cmd_count + 1, sizeof(deferred_cmd))))
+		return NULL;
+	cmds = c;
+
+	c = &cmds[cmd_count++];
+	memset(c, 0, sizeof(*c));
+	c->type = type;
+	c->x1 = x1;
+	c->y1 = y1;
+	c->x2 = x2;
+	c->y2 = y2;
+	return c;
+}
+
+/*
+  Indica si `src` puede leerse desde los hilos con la copia propia. Las hojas
+  con color key en RLE se decodifican aquí una sola vez: bloquearlas en cada
+  tile las decodificaría y recodificaría continuamente. Se marca en `*rle`
+  para devolverles el RLE en deferred_end().
+  */
+static int can_parallel(SDL_Surface *src, int *rle){
+	SDL_PixelFormat *s = src->format, *d = target->format;
+
+	if (s->BitsPerPixel != 32 || d->BitsPerPixel != 32)
+		return 0;
+	if (s->Rmask != d->Rmask || s->Gmask != d->Gmask || s->Bmask != d->Bmask)
+		return 0;
+	if ((src->flags & (SDL_RLEACCEL | SDL_RLEACCELOK)) && (src->flags & SDL_SRCCOLORKEY) &&
+			!(src->flags & SDL_SRCALPHA)) {
+		SDL_SetColorKey(src, SDL_SRCCOLORKEY, s->colorkey);
+		*rle = 1;
+	}
+	return !SDL_MUSTLOCK(src);
+}
+
+void deferred_blit(SDL_Surface *src, const SDL_Rect *srect, int x, int y){
+	deferred_blit_ex(src, srect, x, y, 0, 255, 0xffffff);
+}
+
+void deferred_blit_ex(SDL_Surface *src, const SDL_Rect *srect, int x, int y,
+		int flags, Uint8 alpha, u32 tint){
+	SDL_PixelFormat *f;
+	deferred_cmd *c;
+	SDL_Rect r;
+
+	if (!recording || !src || alpha == 0)
+		return;
+
+	// recorte de la zona origen a la superficie, moviendo el destino igual
+	r.x = 0;
+	r.y = 0;
+	r.w = src->w;
+	r.h = src->h;
+	if (srect) {
+		int x1 = srect->x, y1 = srect->y;
+		int x2 = srect->x + srect->w, y2 = srect->y + srect->h;
+		if (x1 < 0) { x -= x1; x1 = 0; }
+		if (y1 < 0) { y -= y1; y1 = 0; }
+		if (x2 > src->w) x2 = src->w;
+		if (y2 > src->h) y2 = src->h;
+		if (x1 >= x2 || y1 >= y2)
+			return;
+		r.x = x1;
+		r.y = y1;
+		r.w = x2 - x1;
+		r.h = y2 - y1;
+	}
+
+	c = new_cmd(CMD_BLIT, x, y, x + r.w, y + r.h);
+	if (!c)
+		return;
+	if (deferred_keep(src) < 0) {
+		cmd_count--;
+		return;
+	}
+	if (!can_parallel(src, &rec.pins[rec.pin_count - 1].rle))
+		c->type = CMD_SDL_BLIT;
+	c->src = src;
+	c->srect = r;
+	c->x = x;
+	c->y = y;
+	c->flags = flags & (DEFERRED_FLIP_H | DEFERRED_FLIP_V);
+	c->alpha = alpha;
+	c->color = tint;
+
+	// alpha y color key de ahora: la superficie puede cambiar antes de dibujarse
+	f = src->format;
+	if (src->flags & SDL_SRCCOLORKEY)
+		c->flags |= BLIT_KEY;
+	if ((src->flags & SDL_SRCALPHA) && f->Amask)
+		c->flags |= BLIT_PERPIXEL;
+	else if (src->flags & SDL_SRCALPHA)
+		c->alpha = (Uint8)(alpha * f->alpha / 255);
+	c->key = f->colorkey & ~f->Amask;
+
+	// se cuenta al grabar: los hilos no tocan los contadores
+	PERF_COUNT(PERF_BLITS, 1);
+	PERF_COUNT(PERF_PIXELS, r.w * r.h);
+}
+
+void deferred_fill(const SDL_Rect *rect, u32 color){
+	deferred_cmd *c;
+
+	if (!recording)
+		return;
+	if (rect)
+		c = new_cmd(CMD_FILL, rect->x, rect->y, rect->x + rect->w, rect->y + rect->h);
+	else
+		c = new_cmd(CMD_FILL, 0, 0, target->w, target->h);
+	if (!c)
+		return;
+	c->color = color;
+	PERF_COUNT(PERF_PIXELS, (c->x2 - c->x1) * (c->y2 - c->y1));
+}
+
+void deferred_text(int x, int y, const char *text, u32 color){
+	deferred_cmd *c;
+	int len, cw, ch;
+
+	if (!recording || !text || !*text)
+		return;
+
+	// igual que caracter(): la celda mide ch de ancho y cw de alto, avanza cw
+	font_get_size(&cw, &ch);
+	len = (int)strlen(text);
+	c = new_cmd(CMD_TEXT, x, y, x + (len - 1) * cw + ch, y + cw);
+	if (!c)
+		return;
+
+	if ((c->text = cmdlist_text(&rec, text)) < 0) {
+		cmd_count--;
+		return;
+	}
+	c->x = x;
+	c->y = y;
+	c->p1 = cw;
+	c->p2 = ch;
+	c->p3 = len;
+	c->color = color;
+	PERF_COUNT(PERF_GLYPHS, len);
+}
+
+static void record_prim(int kind, int x1, int y1, int x2, int y2, u32 rgba){
+	deferred_cmd *c;
+	int bx1, by1, bx2, by2;
+
+	cmdlist_prim_bounds(kind, x1, y1, x2, y2, &bx1, &by1, &bx2, &by2);
+	if (!(c = new_cmd(CMD_PRIM, bx1, by1, bx2, by2)))
+		return;
+	c->x = x1;
+	c->y = y1;
+	c->p1 = x2;
+	c->p2 = y2;
+	c->p3 = kind;
+	c->color = rgba;
+}
+
+void deferred_line(int x1, int y1, int x2, int y2, u32 rgba){
+	record_prim(CMDLIST_LINE, x1, y1, x2, y2, rgba);
+}
+
+void deferred_rect(int x1, int y1, int x2, int y2, u32 rgba){
+	record_prim(CMDLIST_RECT, x1, y1, x2, y2, rgba);
+}
+
+void deferred_box(int x1, int y1, int x2, int y2, u32 rgba){
+	record_prim(CMDLIST_BOX, x1, y1, x2, y2, rgba);
+}
+
+void deferred_circle(int x, int y, int r, u32 rgba){
+	record_prim(CMDLIST_CIRCLE, x, y, r, 0, rgba);
+}
+
+void deferred_filled_circle(int x, int y, int r, u32 rgba){
+	record_prim(CMDLIST_FILLED_CIRCLE, x, y, r, 0, rgba);
+}
+
+void deferred_call(deferred_func fn, void *ctx, const SDL_Rect *bounds){
+	deferred_cmd *c;
+
+	if (!recording || !fn)
+		return;
+	if (bounds)
+		c = new_cmd(CMD_CALL, bounds->x, bounds->y, bounds->x + bounds->w, bounds->y + bounds->h);
+	else
+		c = new_cmd(CMD_CALL, 0, 0, target->w, target->h);
+	if (c) {
+		c->fn = fn;
+		c->ctx = ctx;
+	}
+}
+
+
+/*
+  Mezcla con tinte, igual que Sprite::drawBlended: s' = s * (t + 1) >> 8 y
+  out = (s' * a + d * (256 - a)) >> 8 por canal.
+  */
+static u32 blend_pixel(u32 s, u32 d, u32 a, u32 tint){
+	u32 out = 0, sc, dc;
+	int shift;
+
+	for (shift = 0; shift < 32; shift += 8) {
+		sc = (((s >> shift) & 0xff) * (((tint >> shift) & 0xff) + 1)) >> 8;
+		dc = (d >> shift) & 0xff;
+		out |= ((sc * a + dc * (256 - a)) >> 8) << shift;
+	}
+	return out;
+}
+
+static void tile_blit(const deferred_cmd *c, int x1, int y1, int x2, int y2){
+	SDL_Surface *src = c->src;
+	SDL_PixelFormat *f = src->format;
+	u32 rgbmask = ~f->Amask, key = c->key;
+	u32 tint = c->color | 0xff000000;
+	int usekey = (c->flags & BLIT_KEY) != 0;
+	int perpixel = (c->flags & BLIT_PERPIXEL) != 0;
+	int flipx = (c->flags & DEFERRED_FLIP_H) != 0;
+	int flipy = (c->flags & DEFERRED_FLIP_V) != 0;
+	int a = c->alpha, n = x2 - x1, x, y, sx, sy, i;
+	const u32 *s;
+	u32 *d;
+
+	for (y = y1; y < y2; y++) {
+		sy = flipy ? c->srect.y + c->srect.h - 1 - (y - c->y) : c->srect.y + (y - c->y);
+		s = ROW32(src, sy);
+		d = ROW32(target, y) + x1;
+
+		// caso común: copia opaca sin volteo, por tramos entre color key
+		if (!perpixel && !flipx && a == 255 && (c->color & 0xffffff) == 0xffffff) {
+			s += c->srect.x + (x1 - c->x);
+			if (!usekey) {
+				memcpy(d, s, n * 4);
+				continue;
+			}
+			i = 0;
+			while (i < n) {
+				int start;
+				while (i < n && (s[i] & rgbmask) == key)
+					i++;
+				start = i;
+				while (i < n && (s[i] & rgbmask) != key)
+					i++;
+				if (i > start)
+					memcpy(d + start, s + start, (i - start) * 4);
+			}
+			continue;
+		}
+
+		for (x = x1; x < x2; x++) {
+			u32 p, pa;
+
+			sx = flipx ? c->srect.x + c->srect.w - 1 - (x - c->x) : c->srect.x + (x - c->x);
+			p = s[sx];
+			if (usekey && (p & rgbmask) == key)
+				continue;
+			pa = a;
+			if (perpixel)
+				pa = (pa * (((p & f->Amask) >> f->Ashift) + 1)) >> 8;
+			if (pa == 0)
+				continue;
+			d[x - x1] = blend_pixel(p, d[x - x1], pa + (pa >> 7), tint);
+		}
+	}
+}
+
+/*
+  Ajusta la vista del tile a la zona [x1,x2) x [y1,y2) del destino, para que
+  SDL_gfx y pixel() recorten al tile y a la caja de la orden.
+  */
+static SDL_Surface *tile_view(deferred_tile *t, int x1, int y1, int x2, int y2){
+	SDL_Surface *v = t->view;
+
+	v->pixels = (u8*)target->pixels + y1 * target->pitch + x1 * target->format->BytesPerPixel;
+	v->w = x2 - x1;
+	v->h = y2 - y1;
+	v->clip_rect.x = 0;
+	v->clip_rect.y = 0;
+	v->clip_rect.w = (Uint16)v->w;
+	v->clip_rect.h = (Uint16)v->h;
+	return v;
+}
+
+static void tile_raster(deferred_tile *t){
+	int i, k, x1, y1, x2, y2, y, bpp = target->format->BytesPerPixel;
+	deferred_cmd *c;
+	SDL_Surface *v;
+
+	for (i = 0; i < t->count; i++) {
+		c = &cmds[t->cmds[i]];
+		x1 = MAX2(c->x1, t->x);
+		y1 = MAX2(c->y1, t->y);
+		x2 = MIN2(c->x2, t->x + t->w);
+		y2 = MIN2(c->y2, t->y + t->h);
+
+		switch (c->type) {
+		case CMD_BLIT:
+			tile_blit(c, x1, y1, x2, y2);
+			break;
+		case CMD_FILL:
+			for (y = y1; y < y2; y++)
+				fill_span((u8*)target->pixels + y * target->pitch + x1 * bpp, bpp, c->color, x2 - x1);
+			break;
+		case CMD_TEXT:
+			v = tile_view(t, x1, y1, x2, y2);
+			for (k = 0; k < c->p3; k++) {
+				int cx = c->x + k * c->p1;
+				if (cx + c->p2 <= x1 || cx >= x2)
+					continue;
+				caracter_surface(v, cx - x1, c->y - y1, c->p1, c->p2, rec.text[c->text + k], c->color);
+			}
+			break;
+		case CMD_PRIM:
+			v = tile_view(t, x1, y1, x2, y2);
+			cmdlist_prim_draw(v, c->p3, c->x, c->y, c->p1, c->p2, x1, y1, c->color);
+			break;
+		case CMD_CALL:
+			c->fn(tile_view(t, x1, y1, x2, y2), x1, y1, c->ctx);
+			break;
+		}
+	}
+}
+
+static void raster_job(void *ctx, int first, int last){
+	int i;
+
+	(void)ctx;
+	for (i = first; i < last; i++)
+		tile_raster(&tiles[order[i]]);
+}
+
+static int tile_push(deferred_tile *t, int cmd){
+	int *p = (int*)cmdlist_grow(t->cmds, &t->cap, t->count + 1, sizeof(int));
+
+	if (!p)
+		return 0;
+	t->cmds = p;
+	t->cmds[t->count++] = cmd;
+	return 1;
+}
+
+/*
+  Reparte las órdenes [first, last) en tiles y dibuja los tiles en paralelo.
+  Los tiles con trabajo se intercalan por hilo para que cada uno reciba
+  zonas de toda la pantalla y no una franja entera.
+  */
+static void flush(int first, int last){
+	int i, tx, ty, n = tiles_x * tiles_y, threads, r, count = 0;
+	deferred_cmd *c;
+
+	if (first >= last)
+		return;
+
+	for (i = 0; i < n; i++)
+		tiles[i].count = 0;
+
+	for (i = first; i < last; i++) {
+		c = &cmds[i];
+		for (ty = c->y1 / DEFERRED_TILE; ty <= (c->y2 - 1) / DEFERRED_TILE; ty++)
+			for (tx = c->x1 / DEFERRED_TILE; tx <= (c->x2 - 1) / DEFERRED_TILE; tx++)
+				tile_push(&tiles[ty * tiles_x + tx], i);
+	}
+
+	threads = job_pool_threads();
+	for (r = 0; r < threads; r++)
+		for (i = r; i < n; i += threads)
+			if (tiles[i].count)
+				order[count++] = i;
+
+	if (count > 1)
+		job_pool_for(raster_job, NULL, count);
+	else
+		raster_job(NULL, 0, count);
+}
+
+int deferred_end(){
+	int i, seg = 0, locked, total = cmd_count;
+	deferred_cmd *c;
+	PERF_TIMER_BEGIN(PERF_DEFERRED_NS);
+
+	if (!recording)
+		return 0;
+	recording = 0;
+
+	locked = SDL_MUSTLOCK(target) && SDL_LockSurface(target) == 0;
+
+	for (i = 0; i < cmd_count; i++) {
+		c = &cmds[i];
+		if (c->type != CMD_SDL_BLIT)
+			continue;
+
+		// lo anterior se dibuja ya; SDL_BlitSurface necesita el destino desbloqueado
+		flush(seg, i);
+		if (locked)
+			SDL_UnlockSurface(target);
+		{
+			SDL_Rect srect = c->srect, drect;
+			drect.x = (Sint16)c->x;
+			drect.y = (Sint16)c->y;
+			SDL_BlitSurface(c->src, &srect, target, &drect);
+		}
+		if (locked)
+			locked = SDL_LockSurface(target) == 0;
+		seg = i + 1;
+	}
+	flush(seg, cmd_count);
+
+	if (locked)
+		SDL_UnlockSurface(target);
+
+	for (i = 0; i < cmd_count; i++)
+		dirty_rect_add_xywh(target, cmds[i].x1, cmds[i].y1, cmds[i].x2 - cmds[i].x1, cmds[i].y2 - cmds[i].y1);
+
+	cmdlist_reset(&rec);
+	cmd_count = 0;
+	PERF_TIMER_END(PERF_DEFERRED_NS);
+	return total;
+}
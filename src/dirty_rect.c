@@ -0,0 +1,171 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <SDL/SDL.h>
+#include <types.h>
+#include <video.h>
+#include <dirty_rect.h>
+
+
+// caja interna: esquinas [x1,x2) x [y1,y2)
+typedef struct {
+	int x1, y1, x2, y2;
+} dirty_box;
+
+static int dirty_on = 0;
+static int dirty_full = 0;
+static int dirty_count = 0;
+static dirty_box boxes[DIRTY_MAX_RECTS];
+static SDL_Rect rects[DIRTY_MAX_RECTS];
+
+
+static int box_area(const dirty_box *b){
+	return (b->x2 - b->x1) * (b->y2 - b->y1);
+}
+
+static int box_contains(const dirty_box *a, const dirty_box *b){
+	return b->x1 >= a->x1 && b->y1 >= a->y1 && b->x2 <= a->x2 && b->y2 <= a->y2;
+}
+
+static void box_union(const dirty_box *a, const dirty_box *b, dirty_box *out){
+	out->x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+	out->y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+	out->x2 = a->x2 > b->x2 ? a->x2 : b->x2;
+	out->y2 = a->y2 > b->y2 ? a->y2 : b->y2;
+}
+
+
+/**
+ * @brief Inserta una caja ya recortada fusionándola con las existentes.
+ *
+ * Cada fusión puede hacer que la caja resultante alcance a otras, por eso
+ * se vuelve a recorrer la lista hasta que no haya más fusiones.
+ */
+static void dirty_insert(dirty_box b){
+	int i, merged;
+	dirty_box u;
+
+	// caso más común: el último rectángulo ya cubre el nuevo
+	if (dirty_count > 0 && box_contains(&boxes[dirty_count - 1], &b))
+		return;
+
+	do {
+		merged = 0;
+		for (i = 0; i < dirty_count; i++) {
+			if (box_contains(&boxes[i], &b))
+				return;
+
+			box_union(&boxes[i], &b, &u);
+			if (box_area(&u) <= box_area(&boxes[i]) + box_area(&b) + DIRTY_MERGE_SLACK) {
+				b = u;
+				boxes[i] = boxes[--dirty_count];
+				merged = 1;
+				break;
+			}
+		}
+	} while (merged);
+
+	if (dirty_count >= DIRTY_MAX_RECTS) {
+		dirty_full = 1;
+		return;
+	}
+
+	boxes[dirty_count++] = b;
+}
+
+
+void dirty_rect_enable(int enable){
+	dirty_on = enable ? 1 : 0;
+	dirty_count = 0;
+	dirty_full = 1;
+}
+
+int dirty_rect_enabled(){
+	return dirty_on;
+}
+
+void dirty_rect_add_xywh(SDL_Surface *dst, int x, int y, int w, int h){
+	dirty_box b;
+
+	if (!dirty_on || dirty_full || !vram || dst != vram)
+		return;
+
+	// recorta a la pantalla
+	b.x1 = x < 0 ? 0 : x;
+	b.y1 = y < 0 ? 0 : y;
+	b.x2 = x + w > vram->w ? vram->w : x + w;
+	b.y2 = y + h > vram->h ? vram->h : y + h;
+
+	if (b.x1 >= b.x2 || b.y1 >= b.y2)
+		return;
+
+	dirty_insert(b);
+}
+
+void dirty_rect_add(SDL_Surface *dst, const SDL_Rect *rect){
+	if (!rect) {
+		if (dst == vram)
+			dirty_rect_add_all();
+		return;
+	}
+	dirty_rect_add_xywh(dst, rect->x, rect->y, rect->w, rect->h);
+}
+
+void dirty_rect_add_bounds(SDL_Surface *dst, int x1, int y1, int x2, int y2){
+	int t;
+
+	if (x1 > x2) {
+		t = x1; x1 = x2; x2 = t;
+	}
+	if (y1 > y2) {
+		t = y1; y1 = y2; y2 = t;
+	}
+	dirty_rect_add_xywh(dst, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+void dirty_rect_add_all(){
+	dirty_full = 1;
+}
+
+SDL_Rect *dirty_rect_get(int *count){
+	int i, area = 0;
+
+	if (!vram) {
+		*count = 0;
+		return rects;
+	}
+
+	for (i = 0; i < dirty_count && !dirty_full; i++)
+		area += box_area(&boxes[i]);
+
+	// si casi toda la pantalla cambió, una sola subida completa es más barata
+	if (dirty_full || area * 4 >= vram->w * vram->h * 3) {
+		rects[0].x = 0;
+		rects[0].y = 0;
+		rects[0].w = vram->w;
+		rects[0].h = vram->h;
+		*count = 1;
+		return rects;
+	}
+
+	for (i = 0; i < dirty_count; i++) {
+		rects[i].x = boxes[i].x1;
+		rects[i].y = boxes[i].y1;
+		rects[i].w = boxes[i].x2 - boxes[i].x1;
+		rects[i].h = boxes[i].y2 - boxes[i].y1;
+	}
+	*count = dirty_count;
+	return rects;
+}
+
+void dirty_rect_clear(){
+	dirty_count = 0;
+	dirty_full = 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <video.h>
+#include <dirty_rect.h>
+#include <fill.h>
+#include <perf.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FILL_AVX2 1
+#define FILL_ALIGN 32
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FILL_SSE2 1
+#define FILL_ALIGN 16
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FILL_NEON 1
+#define FILL_ALIGN 16
+#else
+#define FILL_ALIGN 4
+#endif
+
+
+/*
+  Núcleo común: rellena con el patrón de 64 bits `lo, hi` repetido. Con
+  `lo == hi` es un relleno liso. `dst` debe estar alineado a 8 bytes para que
+  el patrón no se desfase; los extremos se hacen en escalar.
+  */
+static void fill_words(u32 *dst, u32 lo, u32 hi, int n, int stream){
+	u32 t;
+
+	// alinea el destino; si el patrón se desplaza se intercambian las fases
+	while (n > 0 && ((size_t)dst & (FILL_ALIGN - 1))) {
+		*dst++ = lo;
+		n--;
+		t = lo; lo = hi; hi = t;
+	}
+
+#if defined(FILL_AVX2)
+	{
+		__m256i v = _mm256_setr_epi32(lo, hi, lo, hi, lo, hi, lo, hi);
+		if (stream) {
+			for (; n >= 32; n -= 32, dst += 32) {
+				_mm256_stream_si256((__m256i*)dst, v);
+				_mm256_stream_si256((__m256i*)(dst + 8), v);
+				_mm256_stream_si256((__m256i*)(dst + 16), v);
+				_mm256_stream_si256((__m256i*)(dst + 24), v);
+			}
+			_mm_sfence();
+		}
+		for (; n >= 32; n -= 32, dst += 32) {
+			_mm256_store_si256((__m256i*)dst, v);
+			_mm256_store_si256((__m256i*)(dst + 8), v);
+			_mm256_store_si256((__m256i*)(dst + 16), v);
+			_mm256_store_si256((__m256i*)(dst + 24), v);
+		}
+		for (; n >= 8; n -= 8, dst += 8)
+			_mm256_store_si256((__m256i*)dst, v);
+	}
+#elif defined(FILL_SSE2)
+	{
+		__m128i v = _mm_setr_epi32(lo, hi, lo, hi);
+		if (stream) {
+			for (; n >= 16; n -= 16, dst += 16) {
+				_mm_stream_si128((__m128i*)dst, v);
+				_mm_stream_si128((__m128i*)(dst + 4), v);
+				_mm_stream_si128((__m128i*)(dst + 8), v);
+				_mm_stream_si128((__m128i*)(dst + 12), v);
+			}
+			_mm_sfence();
+		}
+		for (; n >= 16; n -= 16, dst += 16) {
+			_mm_store_si128((__m128i*)dst, v);
+			_mm_store_si128((__m128i*)(dst + 4), v);
+			_mm_store_si128((__m128i*)(dst + 8), v);
+			_mm_store_si128((__m128i*)(dst + 12), v);
+		}
+		for (; n >= 4; n -= 4, dst += 4)
+			_mm_store_si128((__m128i*)dst, v);
+	}
+#elif defined(FILL_NEON)
+	{
+		u32 p[4];
+		uint32x4_t v;
+
+		(void)stream;
+		p[0] = lo; p[1] = hi; p[2] = lo; p[3] = hi;
+		v = vld1q_u32(p);
+		for (; n >= 16; n -= 16, dst += 16) {
+			vst1q_u32(dst, v);
+			vst1q_u32(dst + 4, v);
+			vst1q_u32(dst + 8, v);
+			vst1q_u32(dst + 12, v);
+		}
+		for (; n >= 4; n -= 4, dst += 4)
+			vst1q_u32(dst, v);
+	}
+#else
+	(void)stream;
+	for (; n >= 2; n -= 2, dst += 2) {
+		dst[0] = lo;
+		dst[1] = hi;
+	}
+#endif
+
+	// cola
+	while (n > 0) {
+		*dst++ = lo;
+		n--;
+		t = lo; lo = hi; hi = t;
+	}
+}
+
+void fill_span32(u32 *dst, u32 color, int n){
+	fill_words(dst, color, color, n, 0);
+}
+
+void fill_span32_pattern(u32 *dst, u32 c1, u32 c2, int n){
+	fill_words(dst, c1, c2, n, 0);
+}
+
+
+/*
+  Rellena `bytes` bytes con un color de 8 o 16 bits replicado en palabras de
+  32 bits. `dst` debe estar alineado al tamaño del píxel.
+  */
+static void fill_bytes(u8 *dst, u32 word, int bytes, int stream){
+	// alinea a 4 bytes con escrituras de 1 o 2 bytes
+	if (((size_t)dst & 1) && bytes >= 1) {
+		*dst++ = (u8)word;
+		bytes--;
+	}
+	if (((size_t)dst & 2) && bytes >= 2) {
+		*(u16*)dst = (u16)word;
+		dst += 2;
+		bytes -= 2;
+	}
+
+	fill_words((u32*)dst, word, word, bytes >> 2, stream);
+	dst += bytes & ~3;
+	bytes &= 3;
+
+	if (bytes >= 2) {
+		*(u16*)dst = (u16)word;
+		dst += 2;
+		bytes -= 2;
+	}
+	if (bytes)
+		*dst = (u8)word;
+}
+
+static void fill_row24(u8 *dst, u32 color, int n){
+	u8 c0 = (u8)color, c1 = (u8)(color >> 8), c2 = (u8)(color >> 16);
+	int i;
+
+	for (i = 0; i < n; i++, dst += 3) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		dst[0] = c2; dst[1] = c1; dst[2] = c0;
+#else
+		dst[0] = c0; dst[1] = c1; dst[2] = c2;
+#endif
+	}
+}
+
+static void fill_row(u8 *dst, int bpp, u32 color, int n, int stream){
+	switch (bpp) {
+	case 1:
+		fill_bytes(dst, (color & 0xff) * 0x01010101u, n, stream);
+		break;
+	case 2:
+		color &= 0xffff;
+		fill_bytes(dst, color | (color << 16), n * 2, stream);
+		break;
+	case 3:
+		fill_row24(dst, color, n);
+		break;
+	default:
+		fill_words((u32*)dst, color, color, n, stream);
+		break;
+	}
+}
+
+void fill_span(void *dst, int bpp, u32 color, int n){
+	fill_row((u8*)dst, bpp, color, n, 0);
+}
+
+
+void fill_rect(SDL_Surface *dst, const SDL_Rect *rect, u32 color){
+	int x1, y1, x2, y2, bpp, row, y, stream;
+	const SDL_Rect *clip;
+	u8 *p;
+
+	if (!dst)
+		return;
+
+	clip = &dst->clip_rect;
+	x1 = clip->x;
+	y1 = clip->y;
+	x2 = clip->x + clip->w;
+	y2 = clip->y + clip->h;
+	if (rect) {
+		if (rect->x > x1) x1 = rect->x;
+		if (rect->y > y1) y1 = rect->y;
+		if (rect->x + rect->w < x2) x2 = rect->x + rect->w;
+		if (rect->y + rect->h < y2) y2 = rect->y + rect->h;
+	}
+	if (x1 >= x2 || y1 >= y2)
+		return;
+
+	bpp = dst->format->BytesPerPixel;
+	row = (x2 - x1) * bpp;
+	stream = FILL_STREAM_BYTES > 0 && row * (y2 - y1) >= FILL_STREAM_BYTES;
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	p = (u8*)dst->pixels + y1 * dst->pitch + x1 * bpp;
+
+	// filas contiguas: una sola pasada sobre todo el bloque
+	if (row == dst->pitch) {
+		fill_row(p, bpp, color, (x2 - x1) * (y2 - y1), stream);
+	} else {
+		for (y = y1; y < y2; y++, p += dst->pitch)
+			fill_row(p, bpp, color, x2 - x1, stream);
+	}
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+
+	dirty_rect_add_xywh(dst, x1, y1, x2 - x1, y2 - y1);
+	PERF_COUNT(PERF_PIXELS, (x2 - x1) * (y2 - y1));
+}
+
+void fill_surface(SDL_Surface *dst, u32 color){
+	fill_rect(dst, NULL, color);
+}
+
+void fill_checker(SDL_Surface *dst, int w, int h, u32 c1, u32 c2){
+	int y;
+	u8 *p;
+
+	if (!dst || dst->format->BytesPerPixel != 4)
+		return;
+
+	if (w > dst->w) w = dst->w;
+	if (h > dst->h) h = dst->h;
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	p = (u8*)dst->pixels;
+	for (y = 0; y < h; y++, p += dst->pitch) {
+		if (y & 1)
+			fill_words((u32*)p, c2, c1, w, 0);
+		else
+			fill_words((u32*)p, c1, c2, w, 0);
+	}
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+
+	dirty_rect_add_xywh(dst, 0, 0, w, h);
+}
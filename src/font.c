@@ -18,6 +18,10 @@
 
 #include <pixel.h>
 #include <video.h>
+#include <dirty_rect.h>
+#include <deferred.h>
+#include <render_queue.h>
+#include <perf.h>
 
 
 struct bitmapfontMODE {
@@ -290,14 +294,34 @@ static char font_data[256*8] = {
 
 void caracter(int x, int y, const char ascii, unsigned int color ){
 	// Los valores de la estructura FONTMODE definen el tamaño de las letras.
+    dirty_rect_add_xywh(vram, x, y, FONTMODE.alto, FONTMODE.ancho);//celda completa del caracter
+    caracter_surface(vram, x, y, FONTMODE.ancho, FONTMODE.alto, ascii, color);
+    PERF_COUNT(PERF_GLYPHS, 1);
+    return;//retornas el control
+}
+
+void caracter_surface(SDL_Surface *dst, int x, int y, int w, int h, const char ascii, unsigned int color){
     int X,Y,W,H;//variables a usar
-    for (Y=0; Y<FONTMODE.ancho; ++Y)//for para abrir ALTO
-        for (X=0; X<FONTMODE.alto; ++X){//for para abrir ANCHO
-			W = (8 * X / FONTMODE.ancho);//estiramiento calcula cuantos pixeles deveran ser rellenados a lo largo dependiendo el tama�o
-            H = (8 * Y / FONTMODE.alto);//estiramiento  calcula cuantos pixeles deveran ser rellenados a lo alto dependiendo el tama�o 
-            if ((font_data[ H+(ascii)*8 ]>>W) & 1 ){ pixel(vram,  X+x,Y+y, color ); }//esto no lo entiendo bien
+    Uint32 *row;
+    // escribe los píxeles directamente: pixel() bloquearía la superficie en cada uno
+    if (!dst) return;
+    if (SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) < 0) return;
+    for (Y=0; Y<w; ++Y){//for para abrir ALTO
+        if (Y+y < 0 || Y+y >= dst->h) continue;
+        row = (Uint32 *)((Uint8 *)dst->pixels + (Y+y) * dst->pitch);
+        for (X=0; X<h; ++X){//for para abrir ANCHO
+            if (X+x < 0 || X+x >= dst->w) continue;
+			W = (8 * X / w);//estiramiento calcula cuantos pixeles deveran ser rellenados a lo largo dependiendo el tama�o
+            H = (8 * Y / h);//estiramiento  calcula cuantos pixeles deveran ser rellenados a lo alto dependiendo el tama�o 
+            if ((font_data[ H+((unsigned char)ascii)*8 ]>>W) & 1 ){ row[X+x] = color; }
         }
-    return;//retornas el control
+    }
+    if (SDL_MUSTLOCK(dst)) SDL_UnlockSurface(dst);
+}
+
+void font_get_size(int *w, int *h){
+    *w = FONTMODE.ancho;
+    *h = FONTMODE.alto;
 }
 
 void fontsize( int w, int h ){
@@ -309,6 +333,14 @@ void fontsize( int w, int h ){
 void print(int x, int y, char *text, unsigned int color_t){
      int i;
      int longitud = strlen(text);//es necesario conocer la longitud?
+     if (deferred_target() == vram && vram) {//grabando: se dibuja al cerrar el frame
+          deferred_text(x, y, text, color_t);
+          return;
+     }
+     if (render_queue_target() == vram && vram) {
+          render_queue_text(x, y, text, color_t, render_queue_layer(), 0);
+          return;
+     }
      for(i=0;i<longitud;i++){//recorreremos la derecha
           caracter((x+i*(FONTMODE.ancho)),y,(*text++),color_t);
            }
@@ -1,8 +1,16 @@
 #include <gfxtexture.h>
-#include <SDL/SDL_image.h>
+#include <SheetRegistry.h>
 #include <SDL_rotozoom.h>
 #include <SDL_gfxPrimitives.h>
+#include <dirty_rect.h>
+#include <fill.h>
+#include <gradient.h>
+#include <pixfmt.h>
+#include <deferred.h>
+#include <render_queue.h>
+#include <perf.h>
 #include <cstdio>
+#include <cmath>
 
 #define nullptr NULL
 
@@ -21,22 +29,36 @@ void GfxTexture::free_surface(SDL_Surface * &surf)
 
 void GfxTexture::update_pixels()
 {
+	work_surface = work.get();
 	pixels = work_surface ? reinterpret_cast < u32 * >(work_surface->pixels) : nullptr;
 }
 
+bool GfxTexture::make_unique()
+{
+	// copia al escribir: la imagen puede venir compartida del registro
+	if (!work.shared())
+		return true;
+	if (!work.detach())
+		return false;
+	update_pixels();
+	return true;
+}
+
 // / ======================
 // / Constructor / Destructor
 // / ======================
 
-GfxTexture::GfxTexture():surface(nullptr), work_surface(nullptr), pixels(nullptr),
-x(0), y(0), alpha(255), rotation(0.0f), scale(1.0f)
+GfxTexture::GfxTexture():surface(nullptr), surface_w(0), surface_h(0), persistent(false),
+applied_alpha(-1), work_surface(nullptr), pixels(nullptr), x(0), y(0), alpha(255),
+rotation(0.0f), scale(1.0f), cache_current(nullptr), cache_limit(0), cache_used(0),
+cache_angle_steps(256), cache_scale_steps(8), dirty(DIRTY_CONTENT)
 {
 }
 
 GfxTexture::~GfxTexture()
 {
+	clear_cache();
 	free_surface(surface);
-	free_surface(work_surface);
 }
 
 // / ======================
@@ -45,60 +67,36 @@ GfxTexture::~GfxTexture()
 
 bool GfxTexture::init(int w, int h)
 {
-	free_surface(work_surface);
-
-	work_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0, 0, 0, 0);
+	invalidate();
+	work = SheetHandle::adopt(SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0, 0, 0, 0));
+	update_pixels();
 	if (!work_surface)
 	{
 		printf("SDL_CreateRGBSurface error: %s\n", SDL_GetError());
 		return false;
 	}
+	PERF_COUNT(PERF_SURFACES, 1);
 
-	update_pixels();
 	return true;
 }
 
 bool GfxTexture::load_image(const char *filename)
 {
-	free_surface(work_surface);
-
-	SDL_Surface *temp = IMG_Load(filename);
-	if (!temp)
-	{
-		printf("IMG_Load error: %s\n", IMG_GetError());
-		return false;
-	}
-
-	work_surface = SDL_DisplayFormat(temp);
-	SDL_FreeSurface(temp);
+	invalidate();
 
+	// la misma imagen cargada en varias texturas se comparte
+	work = SheetRegistry::loadFile(filename);
 	update_pixels();
-	return true;
+	return work_surface != nullptr;
 }
 
 bool GfxTexture::load_frommem(u8 * buffer, int len)
 {
-	free_surface(work_surface);
-
-	SDL_RWops *mem_rwops = SDL_RWFromMem(buffer, sizeof(u8) * len);
-	if (!mem_rwops)
-	{
-		printf("SDL_RWFromMem error: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_Surface *temp = IMG_Load_RW(mem_rwops, 1);
-	if (!temp)
-	{
-		printf("IMG_Load_RW error: %s\n", SDL_GetError());
-		return false;
-	}
-
-	work_surface = SDL_DisplayFormat(temp);
-	SDL_FreeSurface(temp);
+	invalidate();
 
+	work = SheetRegistry::loadMemory(buffer, sizeof(u8) * len);
 	update_pixels();
-	return true;
+	return work_surface != nullptr;
 }
 
 bool GfxTexture::load_from_surface(SDL_Surface * surf)
@@ -106,17 +104,17 @@ bool GfxTexture::load_from_surface(SDL_Surface * surf)
 	if (!surf)
 		return false;
 
-	free_surface(work_surface);
+	invalidate();
 
 	// Copia la superficie para no modificar la original
-	work_surface = SDL_ConvertSurface(surf, surf->format, surf->flags);
+	work = SheetHandle::adopt(SDL_ConvertSurface(surf, surf->format, surf->flags));
+	update_pixels();
 	if (!work_surface)
 	{
 		printf("SDL_ConvertSurface error: %s\n", SDL_GetError());
 		return false;
 	}
 
-	update_pixels();
 	return true;
 }
 
@@ -130,16 +128,12 @@ void GfxTexture::fill(u8 r, u8 g, u8 b)
 	if (!work_surface)
 		return;
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_LockSurface(work_surface);
-
-	u32 color = SDL_MapRGB(work_surface->format, r, g, b);
-	int total = work_surface->w * work_surface->h;
-	for (int i = 0; i < total; i++)
-		pixels[i] = color;
+	if (!make_unique())
+		return;
+	invalidate();
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_UnlockSurface(work_surface);
+	pixfmt scratch;
+	fill_surface(work_surface, pixfmt_pack(pixfmt_get(work_surface->format, &scratch), r, g, b));
 }
 
 void GfxTexture::fill_checkerboard(u8 r1, u8 g1, u8 b1, u8 r2, u8 g2, u8 b2, int block_size)
@@ -147,12 +141,18 @@ void GfxTexture::fill_checkerboard(u8 r1, u8 g1, u8 b1, u8 r2, u8 g2, u8 b2, int
 	if (!work_surface || work_surface->format->BytesPerPixel != 4)
 		return;
 
+	if (!make_unique())
+		return;
+	invalidate();
+
 	if (SDL_MUSTLOCK(work_surface))
 		SDL_LockSurface(work_surface);
 
 	int pitch = work_surface->pitch / 4;
-	Uint32 c1 = SDL_MapRGB(work_surface->format, r1, g1, b1);
-	Uint32 c2 = SDL_MapRGB(work_surface->format, r2, g2, b2);
+	pixfmt scratch;
+	const pixfmt *pf = pixfmt_get(work_surface->format, &scratch);
+	Uint32 c1 = pixfmt_pack(pf, r1, g1, b1);
+	Uint32 c2 = pixfmt_pack(pf, r2, g2, b2);
 
 	for (int y = 0; y < work_surface->h; y++)
 	{
@@ -173,6 +173,10 @@ void GfxTexture::fill_checkerboard_colors(u32 c1, u32 c2, int block_size)
 	if (!work_surface || work_surface->format->BytesPerPixel != 4)
 		return;
 
+	if (!make_unique())
+		return;
+	invalidate();
+
 	if (SDL_MUSTLOCK(work_surface))
 		SDL_LockSurface(work_surface);
 
@@ -196,27 +200,11 @@ void GfxTexture::fill_horizontal_gradient(Uint32 color1, Uint32 color2)
 	if (!work_surface)
 		return;
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_LockSurface(work_surface);
-
-	Uint8 r1, g1, b1, r2, g2, b2;
-	SDL_GetRGB(color1, work_surface->format, &r1, &g1, &b1);
-	SDL_GetRGB(color2, work_surface->format, &r2, &g2, &b2);
-
-	for (int x = 0; x < work_surface->w; x++)
-	{
-		float t = static_cast < float >(x) / (work_surface->w - 1);
-		Uint8 r = static_cast < Uint8 > ((1 - t) * r1 + t * r2);
-		Uint8 g = static_cast < Uint8 > ((1 - t) * g1 + t * g2);
-		Uint8 b = static_cast < Uint8 > ((1 - t) * b1 + t * b2);
-
-		Uint32 blended_color = SDL_MapRGB(work_surface->format, r, g, b);
-		for (int y = 0; y < work_surface->h; y++)
-			pixels[y * work_surface->w + x] = blended_color;
-	}
+	if (!make_unique())
+		return;
+	invalidate();
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_UnlockSurface(work_surface);
+	gradient_horizontal(work_surface, color1, color2);
 }
 
 void GfxTexture::fill_vertical_gradient(Uint32 color1, Uint32 color2)
@@ -224,28 +212,23 @@ void GfxTexture::fill_vertical_gradient(Uint32 color1, Uint32 color2)
 	if (!work_surface)
 		return;
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_LockSurface(work_surface);
+	if (!make_unique())
+		return;
+	invalidate();
 
-	Uint8 r1, g1, b1, r2, g2, b2;
-	SDL_GetRGB(color1, work_surface->format, &r1, &g1, &b1);
-	SDL_GetRGB(color2, work_surface->format, &r2, &g2, &b2);
+	gradient_vertical(work_surface, color1, color2);
+}
 
-	int pitch = work_surface->pitch / 4;
-	for (int y = 0; y < work_surface->h; y++)
-	{
-		float t = static_cast < float >(y) / (work_surface->h - 1);
-		Uint8 r = static_cast < Uint8 > ((1 - t) * r1 + t * r2);
-		Uint8 g = static_cast < Uint8 > ((1 - t) * g1 + t * g2);
-		Uint8 b = static_cast < Uint8 > ((1 - t) * b1 + t * b2);
+void GfxTexture::fill_radial_gradient(Uint32 color1, Uint32 color2)
+{
+	if (!work_surface)
+		return;
 
-		Uint32 color = SDL_MapRGB(work_surface->format, r, g, b);
-		for (int x = 0; x < work_surface->w; x++)
-			pixels[y * pitch + x] = color;
-	}
+	if (!make_unique())
+		return;
+	invalidate();
 
-	if (SDL_MUSTLOCK(work_surface))
-		SDL_UnlockSurface(work_surface);
+	gradient_radial(work_surface, color1, color2);
 }
 
 // / ======================
@@ -254,14 +237,24 @@ void GfxTexture::fill_vertical_gradient(Uint32 color1, Uint32 color2)
 
 void GfxTexture::set_scale(float percent)
 {
+	if (scale != percent)
+		dirty |= DIRTY_GEOMETRY;
 	scale = percent;
 }
 
 void GfxTexture::set_rotation(float angleDegrees)
 {
+	if (rotation != angleDegrees)
+		dirty |= DIRTY_GEOMETRY;
 	rotation = angleDegrees;
 }
 
+void GfxTexture::invalidate()
+{
+	clear_cache();
+	dirty |= DIRTY_CONTENT;
+}
+
 void GfxTexture::applyTransparency(Uint8 r, Uint8 g, Uint8 b)
 {
 	if (surface)
@@ -271,18 +264,82 @@ void GfxTexture::applyTransparency(Uint8 r, Uint8 g, Uint8 b)
 
 void GfxTexture::render(SDL_Surface * dst)
 {
-	if (!dst || !surface)
+	// solo se vuelve a muestrear si cambió la geometría o el contenido;
+	// posición y alpha se aplican en el blit
+	if (dirty)
+		rotozoom();
+
+	SDL_Surface *out = cache_current ? cache_current->surf : surface;
+	if (!dst || !out)
 		return;
 
-	int rotatedWidth = surface->w;
-	int rotatedHeight = surface->h;
-	SDL_Rect dstRect = { static_cast < Sint16 > (x - rotatedWidth / 2),
-		static_cast < Sint16 > (y - rotatedHeight / 2),
-		rotatedWidth, rotatedHeight
+	int out_w = cache_current ? out->w : surface_w;
+	int out_h = cache_current ? out->h : surface_h;
+	int &out_alpha = cache_current ? cache_current->applied_alpha : applied_alpha;
+
+	SDL_Rect srcRect = { 0, 0, static_cast < Uint16 > (out_w),
+		static_cast < Uint16 > (out_h)
+	};
+	SDL_Rect dstRect = { static_cast < Sint16 > (x - out_w / 2),
+		static_cast < Sint16 > (y - out_h / 2),
+		static_cast < Uint16 > (out_w), static_cast < Uint16 > (out_h)
 	};
 
-	SDL_SetAlpha(surface, SDL_SRCALPHA, alpha);
-	SDL_BlitSurface(surface, nullptr, dst, &dstRect);
+	if (dst == deferred_target() || dst == render_queue_target())
+	{
+		// el alpha va en la orden y no en la superficie, que puede cambiar
+		// antes de cerrar el frame; la orden guarda su propia referencia
+		if (out_alpha != -1)
+		{
+			SDL_SetAlpha(out, 0, 255);
+			out_alpha = -1;
+		}
+		if (dst == deferred_target())
+			deferred_blit_ex(out, &srcRect, dstRect.x, dstRect.y, 0, alpha, 0xffffff);
+		else
+			render_queue_blit_alpha(out, &srcRect, dstRect.x, dstRect.y, alpha,
+									render_queue_layer(), 0);
+		return;
+	}
+	// SDL_SetAlpha decodifica el RLE de la superficie, solo si cambió
+	if (out_alpha != alpha)
+	{
+		SDL_SetAlpha(out, SDL_SRCALPHA, alpha);
+		out_alpha = alpha;
+	}
+	SDL_BlitSurface(out, &srcRect, dst, &dstRect);
+	dirty_rect_add(dst, &dstRect);
+	PERF_COUNT(PERF_BLITS, 1);
+	PERF_COUNT(PERF_PIXELS, dstRect.w * dstRect.h);
+}
+
+void GfxTexture::render_direct(SDL_Surface * dst)
+{
+	if (!dst || !work_surface)
+		return;
+
+	SDL_Rect dstRect;
+	u32 key = SDL_MapRGB(work_surface->format, 0, 0, 0);
+
+	if (dst == deferred_target() || dst == render_queue_target())
+	{
+		// el rotozoom directo escribe en dst al momento: se graba la copia
+		rotozoom();
+		render(dst);
+		return;
+	}
+
+	if (rotozoomSurfaceXYBlit(work_surface, dst, x, y, rotation, scale, scale,
+							  SDL_SRCCOLORKEY, key, alpha, &dstRect) != 0)
+	{
+		// formato no soportado por la ruta directa
+		rotozoom();
+		render(dst);
+		return;
+	}
+	dirty_rect_add(dst, &dstRect);
+	PERF_COUNT(PERF_ROTOZOOMS, 1);
+	PERF_COUNT(PERF_PIXELS, dstRect.w * dstRect.h);
 }
 
 void GfxTexture::set_position(int px, int py)
@@ -296,9 +353,36 @@ void GfxTexture::set_alpha(u8 a)
 	alpha = a;
 }
 
+void GfxTexture::set_persistent(bool enable)
+{
+	if (persistent != enable)
+	{
+		free_surface(surface);
+		surface_w = surface_h = 0;
+		dirty |= DIRTY_GEOMETRY;
+	}
+	persistent = enable;
+}
+
 void GfxTexture::rotozoom()
 {
+	if (!dirty && (cache_current || surface))
+		return;
+	dirty = 0;
+
+	cache_current = nullptr;
+	if (cache_limit > 0 && rotozoom_cached())
+		return;
+
+	if (persistent && work_surface && work_surface->format->BitsPerPixel == 32)
+	{
+		rotozoom_persistent();
+		return;
+	}
+
 	free_surface(surface);
+	surface_w = surface_h = 0;
+	applied_alpha = -1;
 
 	//surface = rotozoomSurface(work_surface, rotation, scale, SMOOTHING_ON);
 	surface = rotozoomSurface(work_surface, rotation, scale,0);
@@ -307,17 +391,204 @@ void GfxTexture::rotozoom()
 		printf("Error en rotozoomSurface: %s\n", SDL_GetError());
 		return;
 	}
+	PERF_COUNT(PERF_ROTOZOOMS, 1);
+	PERF_COUNT(PERF_SURFACES, 1);
 
+	surface_w = surface->w;
+	surface_h = surface->h;
 	applyTransparency(0, 0, 0);
 }
 
+void GfxTexture::rotozoom_persistent()
+{
+	int w, h, result;
+
+	// una orden diferida pendiente la está leyendo: no se escribe encima
+	if (surface && surface->refcount > 1)
+	{
+		free_surface(surface);
+		surface_w = surface_h = 0;
+	}
+
+	result = rotozoomSurfaceXYInto(work_surface, surface, rotation, scale, scale, 0, &w, &h);
+
+	if (result == -2)
+	{
+		// El buffer crece hasta el tamaño máximo visto y no vuelve a encoger
+		int buf_w = (surface && surface->w > w) ? surface->w : w;
+		int buf_h = (surface && surface->h > h) ? surface->h : h;
+
+		free_surface(surface);
+		surface = SDL_CreateRGBSurface(SDL_SWSURFACE, buf_w, buf_h, 32,
+									   work_surface->format->Rmask,
+									   work_surface->format->Gmask,
+									   work_surface->format->Bmask,
+									   work_surface->format->Amask);
+		if (!surface)
+		{
+			printf("SDL_CreateRGBSurface error: %s\n", SDL_GetError());
+			surface_w = surface_h = 0;
+			return;
+		}
+		PERF_COUNT(PERF_SURFACES, 1);
+
+		applied_alpha = -1;
+		applyTransparency(0, 0, 0);
+		result = rotozoomSurfaceXYInto(work_surface, surface, rotation, scale, scale, 0, &w, &h);
+	}
+
+	if (result != 0)
+	{
+		printf("Error en rotozoomSurfaceXYInto: %d\n", result);
+		surface_w = surface_h = 0;
+		return;
+	}
+	PERF_COUNT(PERF_ROTOZOOMS, 1);
+
+	surface_w = w;
+	surface_h = h;
+}
+
+
+// / ======================
+// / Caché de transformaciones
+// / ======================
+
+void GfxTexture::enable_cache(u32 max_bytes, int angle_steps, int scale_steps)
+{
+	clear_cache();
+	dirty |= DIRTY_GEOMETRY;
+	cache_limit = max_bytes;
+	cache_angle_steps = angle_steps > 0 ? angle_steps : 256;
+	cache_scale_steps = scale_steps > 0 ? scale_steps : 8;
+}
+
+void GfxTexture::disable_cache()
+{
+	clear_cache();
+	dirty |= DIRTY_GEOMETRY;
+	cache_limit = 0;
+}
+
+void GfxTexture::clear_cache()
+{
+	for (CacheList::iterator it = cache.begin(); it != cache.end(); ++it)
+		SDL_FreeSurface(it->surf);
+	cache.clear();
+	cache_index.clear();
+	cache_current = nullptr;
+	cache_used = 0;
+}
+
+int GfxTexture::cache_angle_index(float angle) const
+{
+	int i = static_cast < int >(floor(angle * cache_angle_steps / 360.0 + 0.5)) % cache_angle_steps;
+	return i < 0 ? i + cache_angle_steps : i;
+}
+
+int GfxTexture::cache_scale_index(float zoom) const
+{
+	return static_cast < int >(floor(log(zoom) / log(2.0) * cache_scale_steps + 0.5));
+}
+
+bool GfxTexture::rotozoom_cached()
+{
+	if (!work_surface || scale <= 0.0f)
+		return false;
+
+	cache_current = cache_fetch(cache_angle_index(rotation), cache_scale_index(scale), true);
+	return cache_current != nullptr;
+}
+
+GfxTexture::CacheEntry * GfxTexture::cache_fetch(int angle_index, int scale_index, bool evict)
+{
+	// índice de escala con signo en la mitad alta de la clave
+	u32 key = static_cast < u32 > (angle_index & 0xffff) |
+		(static_cast < u32 > (scale_index + 0x8000) << 16);
+
+	std::map < u32, CacheList::iterator >::iterator found = cache_index.find(key);
+	if (found != cache_index.end())
+	{
+		// mover al frente no invalida los iteradores de std::list
+		cache.splice(cache.begin(), cache, found->second);
+		return &cache.front();
+	}
+
+	double angle = angle_index * 360.0 / cache_angle_steps;
+	double zoom = pow(2.0, static_cast < double >(scale_index) / cache_scale_steps);
+
+	// se descarta antes de calcular si no cabría nunca (o sin expulsar)
+	int w, h;
+	rotozoomSurfaceSize(work_surface->w, work_surface->h, angle, zoom, &w, &h);
+	u32 estimate = static_cast < u32 > (w) * h * work_surface->format->BytesPerPixel;
+	if (estimate > cache_limit || (!evict && cache_used + estimate > cache_limit))
+		return nullptr;
+
+	SDL_Surface *surf = rotozoomSurface(work_surface, angle, zoom, 0);
+	if (!surf)
+	{
+		printf("Error en rotozoomSurface: %s\n", SDL_GetError());
+		return nullptr;
+	}
+	PERF_COUNT(PERF_ROTOZOOMS, 1);
+	PERF_COUNT(PERF_SURFACES, 1);
+	SDL_SetColorKey(surf, SDL_SRCCOLORKEY | SDL_RLEACCEL, SDL_MapRGB(surf->format, 0, 0, 0));
+
+	CacheEntry entry;
+	entry.key = key;
+	entry.surf = surf;
+	entry.applied_alpha = -1;
+	entry.bytes = static_cast < u32 > (surf->pitch) * surf->h;
+
+	while (!cache.empty() && cache_used + entry.bytes > cache_limit)
+	{
+		CacheEntry & old = cache.back();
+		if (&old == cache_current)
+		{
+			cache_current = nullptr;
+			dirty |= DIRTY_GEOMETRY;
+		}
+		cache_used -= old.bytes;
+		cache_index.erase(old.key);
+		SDL_FreeSurface(old.surf);
+		cache.pop_back();
+	}
+
+	cache.push_front(entry);
+	cache_index[key] = cache.begin();
+	cache_used += entry.bytes;
+	return &cache.front();
+}
+
+int GfxTexture::prebake(float min_scale, float max_scale)
+{
+	if (!work_surface || cache_limit == 0 || min_scale <= 0.0f || max_scale < min_scale)
+		return 0;
+
+	int count = 0;
+	int first = cache_scale_index(min_scale);
+	int last = cache_scale_index(max_scale);
+
+	for (int s = first; s <= last; s++)
+	{
+		for (int a = 0; a < cache_angle_steps; a++)
+		{
+			if (!cache_fetch(a, s, false))
+				return count;
+			count++;
+		}
+	}
+	return count;
+}
+
 
 void GfxTexture::set_surface(SDL_Surface * src, int x, int y)
 {
-	if (!src || !work_surface)
+	if (!src || !work_surface || !make_unique())
 		return;
 	SDL_Rect pos = { (Sint16) x, (Sint16) y, 0, 0 };
 	SDL_BlitSurface(src, NULL, work_surface, &pos);
+	invalidate();
 
 }
 
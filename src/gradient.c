@@ -0,0 +1,228 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <dirty_rect.h>
+#include <fill.h>
+#include <pixfmt.h>
+#include <gradient.h>
+
+
+static void store_pixel(u8 *p, int bpp, u32 c){
+	switch (bpp) {
+	case 1:
+		*p = (u8)c;
+		break;
+	case 2:
+		*(u16*)p = (u16)c;
+		break;
+	case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		p[0] = (u8)(c >> 16); p[1] = (u8)(c >> 8); p[2] = (u8)c;
+#else
+		p[0] = (u8)c; p[1] = (u8)(c >> 8); p[2] = (u8)(c >> 16);
+#endif
+		break;
+	default:
+		*(u32*)p = c;
+		break;
+	}
+}
+
+
+void gradient_ramp(SDL_PixelFormat *fmt, u32 c1, u32 c2, u32 *lut, int n){
+	pixfmt scratch;
+	const pixfmt *pf;
+	u8 r1, g1, b1, r2, g2, b2;
+	int r, g, b, dr, dg, db, i;
+
+	if (n <= 0)
+		return;
+
+	pf = pixfmt_get(fmt, &scratch);
+	pixfmt_unpack(pf, c1, &r1, &g1, &b1);
+	pixfmt_unpack(pf, c2, &r2, &g2, &b2);
+	if (n == 1) {
+		lut[0] = pixfmt_pack(pf, r1, g1, b1);
+		return;
+	}
+
+	// 16.16 con redondeo; el error acumulado es menor de medio tono
+	dr = (r2 - r1) * 65536 / (n - 1);
+	dg = (g2 - g1) * 65536 / (n - 1);
+	db = (b2 - b1) * 65536 / (n - 1);
+	r = r1 * 65536 + 0x8000;
+	g = g1 * 65536 + 0x8000;
+	b = b1 * 65536 + 0x8000;
+
+	// un bucle por tipo para que el empaquetado quede en línea
+	switch (pf->kind) {
+	case PIXFMT_ARGB8888:
+		for (i = 0; i < n; i++, r += dr, g += dg, b += db)
+			lut[i] = pixfmt_pack_argb8888(pf->amask, r >> 16, g >> 16, b >> 16);
+		break;
+	case PIXFMT_RGB565:
+		for (i = 0; i < n; i++, r += dr, g += dg, b += db)
+			lut[i] = pixfmt_pack_rgb565(r >> 16, g >> 16, b >> 16);
+		break;
+	default:
+		for (i = 0; i < n; i++, r += dr, g += dg, b += db)
+			lut[i] = pixfmt_pack(pf, r >> 16, g >> 16, b >> 16);
+		break;
+	}
+}
+
+
+void gradient_horizontal(SDL_Surface *dst, u32 c1, u32 c2){
+	int bpp, x, y;
+	u32 *lut = NULL;
+	u8 *row;
+
+	if (!dst || dst->w <= 0 || dst->h <= 0)
+		return;
+
+	bpp = dst->format->BytesPerPixel;
+	if (bpp != 4) {
+		lut = (u32*)malloc(dst->w * sizeof(u32));
+		if (!lut)
+			return;
+		gradient_ramp(dst->format, c1, c2, lut, dst->w);
+	}
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	// la primera fila se genera una vez y el resto son copias
+	row = (u8*)dst->pixels;
+	if (bpp == 4) {
+		gradient_ramp(dst->format, c1, c2, (u32*)row, dst->w);
+	} else {
+		for (x = 0; x < dst->w; x++)
+			store_pixel(row + x * bpp, bpp, lut[x]);
+	}
+	for (y = 1; y < dst->h; y++)
+		memcpy(row + y * dst->pitch, row, dst->w * bpp);
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+
+	free(lut);
+	dirty_rect_add_xywh(dst, 0, 0, dst->w, dst->h);
+}
+
+
+void gradient_vertical(SDL_Surface *dst, u32 c1, u32 c2){
+	int bpp, y;
+	u32 *lut;
+	u8 *row;
+
+	if (!dst || dst->w <= 0 || dst->h <= 0)
+		return;
+
+	lut = (u32*)malloc(dst->h * sizeof(u32));
+	if (!lut)
+		return;
+	gradient_ramp(dst->format, c1, c2, lut, dst->h);
+	bpp = dst->format->BytesPerPixel;
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	row = (u8*)dst->pixels;
+	for (y = 0; y < dst->h; y++, row += dst->pitch)
+		fill_span(row, bpp, lut[y], dst->w);
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+
+	free(lut);
+	dirty_rect_add_xywh(dst, 0, 0, dst->w, dst->h);
+}
+
+
+void gradient_radial(SDL_Surface *dst, u32 c1, u32 c2){
+	u32 lut[GRADIENT_RADIAL_STEPS];
+	u32 thr[GRADIENT_RADIAL_STEPS];
+	Uint64 den;
+	u32 max2, d2;
+	int w, h, cx, cy, bpp, dx, dy, x, k, k0;
+	u8 *idx, *row;
+
+	if (!dst || dst->w <= 0 || dst->h <= 0)
+		return;
+
+	w = dst->w;
+	h = dst->h;
+	cx = w / 2;
+	cy = h / 2;
+	bpp = dst->format->BytesPerPixel;
+
+	// cx >= w-1-cx y cy >= h-1-cy: basta con media fila y media altura
+	idx = (u8*)malloc(cx + 1);
+	if (!idx)
+		return;
+
+	/*
+	  Tono k si round(dist / max * (STEPS-1)) == k. Comparando al cuadrado,
+	  el paso de k a k+1 ocurre cuando d2 >= ((k + 0.5) / (STEPS-1))^2 * max2.
+	  */
+	max2 = cx * cx + cy * cy;
+	den = 4 * (Uint64)(GRADIENT_RADIAL_STEPS - 1) * (GRADIENT_RADIAL_STEPS - 1);
+	for (k = 0; k < GRADIENT_RADIAL_STEPS - 1; k++) {
+		Uint64 num = (Uint64)(2 * k + 1) * (2 * k + 1) * max2;
+		thr[k] = max2 ? (u32)((num + den - 1) / den) : 0xffffffff;
+	}
+	thr[GRADIENT_RADIAL_STEPS - 1] = 0xffffffff;
+
+	gradient_ramp(dst->format, c1, c2, lut, GRADIENT_RADIAL_STEPS);
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	k0 = 0;
+	for (dy = 0; dy <= cy; dy++) {
+		// d2 crece con dx, así que el tono solo avanza: sin sqrt ni divisiones
+		d2 = dy * dy;
+		while (d2 >= thr[k0])
+			k0++;
+		k = k0;
+		for (dx = 0; dx <= cx; dx++) {
+			while (d2 >= thr[k])
+				k++;
+			idx[dx] = (u8)k;
+			d2 += 2 * dx + 1;
+		}
+
+		row = (u8*)dst->pixels + (cy - dy) * dst->pitch;
+		if (bpp == 4) {
+			u32 *p = (u32*)row;
+			for (x = 0; x < cx; x++)
+				p[x] = lut[idx[cx - x]];
+			for (; x < w; x++)
+				p[x] = lut[idx[x - cx]];
+		} else {
+			for (x = 0; x < w; x++)
+				store_pixel(row + x * bpp, bpp, lut[idx[x < cx ? cx - x : x - cx]]);
+		}
+
+		// fila simétrica respecto al centro
+		if (dy > 0 && cy + dy < h)
+			memcpy((u8*)dst->pixels + (cy + dy) * dst->pitch, row, w * bpp);
+	}
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+
+	free(idx);
+	dirty_rect_add_xywh(dst, 0, 0, w, h);
+}
@@ -0,0 +1,177 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifdef WIN32
+#include <windows.h>
+#elif !defined(_EE)
+#include <unistd.h>
+#endif
+
+#include <SDL/SDL.h>
+#include <types.h>
+#include <job_pool.h>
+
+
+static int pool_threads = 1;		// hilos en uso, contando el que llama
+static int pool_quit_flag = 0;
+static int pool_busy = 0;
+static int pool_ids[JOB_POOL_MAX_THREADS];
+static SDL_Thread *pool_thread[JOB_POOL_MAX_THREADS];
+static SDL_sem *pool_start[JOB_POOL_MAX_THREADS];
+static SDL_sem *pool_done = NULL;
+static SDL_mutex *pool_lock = NULL;
+
+// trabajo actual, solo válido mientras pool_busy está activo
+static job_func job_fn = NULL;
+static void *job_ctx = NULL;
+static int job_count = 0;
+static int job_parts = 0;
+
+
+static int cpu_count(){
+#if defined(WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#else
+	return 1;
+#endif
+}
+
+static void job_run_part(int part){
+	int first = (int)((long long)job_count * part / job_parts);
+	int last = (int)((long long)job_count * (part + 1) / job_parts);
+
+	if (first < last)
+		job_fn(job_ctx, first, last);
+}
+
+static int job_worker(void *data){
+	int id = *(int *)data;
+
+	for (;;) {
+		SDL_SemWait(pool_start[id]);
+		if (pool_quit_flag)
+			break;
+		// el hilo que llama procesa la parte 0
+		job_run_part(id + 1);
+		SDL_SemPost(pool_done);
+	}
+	return 0;
+}
+
+
+int job_pool_init(int threads){
+	int i;
+
+	job_pool_quit();
+
+	if (threads <= 0)
+		threads = cpu_count();
+	if (threads > JOB_POOL_MAX_THREADS)
+		threads = JOB_POOL_MAX_THREADS;
+	if (threads <= 1)
+		return pool_threads;
+
+	pool_lock = SDL_CreateMutex();
+	pool_done = SDL_CreateSemaphore(0);
+	if (!pool_lock || !pool_done) {
+		job_pool_quit();
+		return pool_threads;
+	}
+
+	pool_quit_flag = 0;
+	for (i = 0; i < threads - 1; i++) {
+		pool_ids[i] = i;
+		pool_start[i] = SDL_CreateSemaphore(0);
+		pool_thread[i] = pool_start[i] ? SDL_CreateThread(job_worker, &pool_ids[i]) : NULL;
+		if (!pool_thread[i]) {
+			if (pool_start[i]) {
+				SDL_DestroySemaphore(pool_start[i]);
+				pool_start[i] = NULL;
+			}
+			break;
+		}
+	}
+	pool_threads = i + 1;
+
+	return pool_threads;
+}
+
+void job_pool_quit(){
+	int i;
+
+	pool_quit_flag = 1;
+	for (i = 0; i < pool_threads - 1; i++) {
+		SDL_SemPost(pool_start[i]);
+		SDL_WaitThread(pool_thread[i], NULL);
+		SDL_DestroySemaphore(pool_start[i]);
+		pool_thread[i] = NULL;
+		pool_start[i] = NULL;
+	}
+	pool_threads = 1;
+
+	if (pool_done) {
+		SDL_DestroySemaphore(pool_done);
+		pool_done = NULL;
+	}
+	if (pool_lock) {
+		SDL_DestroyMutex(pool_lock);
+		pool_lock = NULL;
+	}
+}
+
+int job_pool_threads(){
+	return pool_threads;
+}
+
+void job_pool_for(job_func func, void *ctx, int count){
+	int i, parts;
+
+	if (count <= 0)
+		return;
+
+	parts = pool_threads < count ? pool_threads : count;
+	if (parts <= 1 || !pool_lock) {
+		func(ctx, 0, count);
+		return;
+	}
+
+	// un reparto a la vez; si ya hay uno en marcha (otro hilo o una llamada
+	// anidada desde un trabajo) se ejecuta aquí mismo
+	SDL_mutexP(pool_lock);
+	if (pool_busy) {
+		SDL_mutexV(pool_lock);
+		func(ctx, 0, count);
+		return;
+	}
+	pool_busy = 1;
+	SDL_mutexV(pool_lock);
+
+	job_fn = func;
+	job_ctx = ctx;
+	job_count = count;
+	job_parts = parts;
+
+	for (i = 0; i < parts - 1; i++)
+		SDL_SemPost(pool_start[i]);
+
+	job_run_part(0);
+
+	for (i = 0; i < parts - 1; i++)
+		SDL_SemWait(pool_done);
+
+	SDL_mutexP(pool_lock);
+	pool_busy = 0;
+	SDL_mutexV(pool_lock);
+}
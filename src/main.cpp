@@ -35,8 +35,13 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
-	// Inicializa video
+	// Inicializa video: en escritorio a 2x con Scale2x/EPX, en PS2 a la
+	// resolución nativa
+#ifndef _EE
+	if (Set_Video_Scaled(SCREEN_WIDTH, SCREEN_HEIGHT, 2, PRESENT_EPX) != 0)
+#else
 	if (Set_Video(SCREEN_WIDTH, SCREEN_HEIGHT) != 0)
+#endif
 	{
 		fprintf(stderr, "Error: al iniciar el video\n");
 		return EXIT_FAILURE;
@@ -69,6 +74,7 @@ int main(int argc, char **argv)
 	work_texture.set_position(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
 	work_texture.set_scale(0.5f);
 	work_texture.set_rotation(20.0f);
+	work_texture.set_persistent(true);
 
 	// Variables de animación
 	float rotation = 0.0f, rotation_step = 0.6f;
@@ -103,7 +109,7 @@ int main(int argc, char **argv)
 		}
 
 		// Limpia pantalla
-		SDL_FillRect(vram, nullptr, 0x00000000);
+		cls();
 
 		// Actualiza animación
 		work_texture.set_rotation(rotation);
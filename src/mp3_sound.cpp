@@ -2,6 +2,7 @@
 #include <dec.h>
 #include <log.h>
 #include <mp3_sound.h>
+#include <perf.h>
 
 
 /* ============================
@@ -111,6 +112,7 @@ int mp3Music::isPlaying() {
    Callback SDL
    ============================ */
 void mp3Music::audioCallback(void* userdata, Uint8* stream, int len) {
+    PERF_SCOPE(PERF_AUDIO_NS);
     mp3Music* music = (mp3Music*) userdata;
     if (!music || !music->playing) {
         memset(stream, 0, len);
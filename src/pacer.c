@@ -0,0 +1,224 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#ifdef WIN32
+#include <windows.h>
+#elif !defined(_EE)
+#include <time.h>
+#endif
+
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <pacer.h>
+
+
+static Uint64 period_ns = 0;			// 0: sin espera
+static int pacing = 1;					// 0: nunca espera (modo sin pantalla)
+static Uint64 step_ns = 1000000000 / 60;
+static int max_steps = 5;
+static Uint64 spin_ns = 1000000;		// margen de espera activa, se ajusta solo
+
+static Uint64 next_ns = 0;				// plazo del frame en curso
+static Uint64 last_begin = 0;
+static Uint64 last_frame = 0;
+static Uint64 acc_ns = 0;
+
+// ventana de estadísticas: anillo de tiempos y su histograma
+static Uint64 ring[PACER_HISTORY];
+static u16 hist[PACER_BUCKETS];
+static int ring_pos = 0;
+static int ring_count = 0;
+static int dropped = 0;
+
+
+Uint64 pacer_now_ns(){
+#if defined(WIN32)
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER c;
+
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&c);
+	return (Uint64)(c.QuadPart / freq.QuadPart) * 1000000000 +
+		(Uint64)(c.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#elif defined(_EE)
+	return (Uint64)SDL_GetTicks() * 1000000;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+
+void pacer_set_rate(int hz){
+	pacer_set_period_ns(hz > 0 ? 1000000000 / hz : 0);
+}
+
+void pacer_set_period_ns(Uint64 ns){
+	period_ns = ns;
+	next_ns = 0;
+}
+
+void pacer_set_enabled(int enable){
+	pacing = enable ? 1 : 0;
+	next_ns = 0;
+}
+
+void pacer_set_step_rate(int hz){
+	if (hz > 0)
+		step_ns = 1000000000 / hz;
+}
+
+void pacer_set_max_steps(int steps){
+	max_steps = steps < 1 ? 1 : steps;
+}
+
+
+void pacer_begin_frame(){
+	Uint64 now = pacer_now_ns(), limit;
+
+	if (!last_begin) {
+		last_begin = now;
+		return;
+	}
+	acc_ns += now - last_begin;
+	last_begin = now;
+
+	// frame-skip: lo que no quepa en max_steps pasos se descarta
+	limit = step_ns * max_steps;
+	if (acc_ns > limit) {
+		dropped += (int)((acc_ns - limit) / step_ns);
+		acc_ns = limit;
+	}
+}
+
+int pacer_step(){
+	if (acc_ns < step_ns)
+		return 0;
+	acc_ns -= step_ns;
+	return 1;
+}
+
+float pacer_step_seconds(){
+	return step_ns / 1e9f;
+}
+
+float pacer_alpha(){
+	return (float)acc_ns / step_ns;
+}
+
+
+static void record(Uint64 ns){
+	int b;
+
+	if (ring_count == PACER_HISTORY) {
+		b = (int)(ring[ring_pos] / PACER_BUCKET_NS);
+		hist[b < PACER_BUCKETS ? b : PACER_BUCKETS - 1]--;
+	} else {
+		ring_count++;
+	}
+	ring[ring_pos] = ns;
+	ring_pos = (ring_pos + 1) % PACER_HISTORY;
+
+	b = (int)(ns / PACER_BUCKET_NS);
+	hist[b < PACER_BUCKETS ? b : PACER_BUCKETS - 1]++;
+}
+
+/*
+  Duerme hasta poco antes de `t` y termina con espera activa. El margen se
+  adapta a lo que el sistema se pasa al despertar: sube de golpe si un
+  despertar llegó tarde y baja poco a poco cuando sobra.
+  */
+static void sleep_until(Uint64 t){
+	Uint64 now = pacer_now_ns(), want, over, target;
+
+	if (t > now + spin_ns) {
+		want = t - spin_ns;
+		SDL_Delay((Uint32)((want - now) / 1000000));
+		now = pacer_now_ns();
+
+		over = now > want ? now - want : 0;
+		target = over * 2 + 100000;
+		if (target > spin_ns)
+			spin_ns = target;
+		else
+			spin_ns = (spin_ns * 7 + target) / 8;
+		if (spin_ns < PACER_SPIN_MIN) spin_ns = PACER_SPIN_MIN;
+		if (spin_ns > PACER_SPIN_MAX) spin_ns = PACER_SPIN_MAX;
+	}
+
+	while (pacer_now_ns() < t)
+		;
+}
+
+void pacer_wait(){
+	Uint64 now = pacer_now_ns();
+
+	if (period_ns && pacing) {
+		// más de un periodo tarde: se pierde la fase en lugar de ir a ráfagas
+		if (!next_ns || now > next_ns + period_ns)
+			next_ns = now;
+		sleep_until(next_ns);
+		now = pacer_now_ns();
+		next_ns += period_ns;
+	}
+
+	if (last_frame)
+		record(now - last_frame);
+	last_frame = now;
+}
+
+
+static Uint64 percentile(int p){
+	int rank, b, seen = 0;
+
+	if (!ring_count)
+		return 0;
+
+	rank = (ring_count * p + 99) / 100;
+	for (b = 0; b < PACER_BUCKETS; b++) {
+		seen += hist[b];
+		if (seen >= rank)
+			break;
+	}
+	if (b == PACER_BUCKETS)
+		b--;
+	return (Uint64)b * PACER_BUCKET_NS + PACER_BUCKET_NS / 2;
+}
+
+void pacer_get_stats(pacer_stats *out){
+	Uint64 sum = 0, worst = 0;
+	int i;
+
+	for (i = 0; i < ring_count; i++) {
+		sum += ring[i];
+		if (ring[i] > worst)
+			worst = ring[i];
+	}
+
+	out->p50 = percentile(50);
+	out->p95 = percentile(95);
+	out->p99 = percentile(99);
+	out->worst = worst;
+	out->mean = ring_count ? sum / ring_count : 0;
+	out->samples = ring_count;
+	out->dropped = dropped;
+}
+
+void pacer_reset_stats(){
+	memset(hist, 0, sizeof(hist));
+	ring_pos = 0;
+	ring_count = 0;
+	dropped = 0;
+	last_frame = 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <video.h>
+#include <font.h>
+#include <fill.h>
+#include <pixfmt.h>
+#include <perf.h>
+
+
+Uint64 perf_counters[PERF_COUNTERS];
+
+static Uint64 last[PERF_COUNTERS];
+static Uint64 peak[PERF_COUNTERS];
+static int frames = 0;
+static Uint64 last_frame_ns = 0;
+static int hud = 0;
+static char hud_buf[64];
+
+static const char *names[PERF_COUNTERS] = {
+	"blits", "pixels", "surfaces", "rotozooms", "glyphs",
+	"frame_ns", "present_ns", "deferred_ns", "queue_ns", "audio_ns"
+};
+
+
+void perf_frame(){
+	Uint64 now = pacer_now_ns();
+	int i;
+
+	if (last_frame_ns)
+		perf_counters[PERF_FRAME_NS] = now - last_frame_ns;
+	last_frame_ns = now;
+
+	for (i = 0; i < PERF_COUNTERS; i++) {
+		last[i] = perf_counters[i];
+		if (last[i] > peak[i])
+			peak[i] = last[i];
+		perf_counters[i] = 0;
+	}
+	frames++;
+}
+
+Uint64 perf_get(int id){
+	return id >= 0 && id < PERF_COUNTERS ? last[id] : 0;
+}
+
+Uint64 perf_get_max(int id){
+	return id >= 0 && id < PERF_COUNTERS ? peak[id] : 0;
+}
+
+int perf_frames(){
+	return frames;
+}
+
+void perf_reset(){
+	memset(perf_counters, 0, sizeof(perf_counters));
+	memset(last, 0, sizeof(last));
+	memset(peak, 0, sizeof(peak));
+	frames = 0;
+	last_frame_ns = 0;
+}
+
+const char *perf_name(int id){
+	return id >= 0 && id < PERF_COUNTERS ? names[id] : "";
+}
+
+
+void perf_show_hud(int enable){
+	hud = enable ? 1 : 0;
+}
+
+int perf_hud_visible(){
+	return hud;
+}
+
+#define MS(id) (last[id] / 1000000.0)
+
+const char *perf_hud_line(int line){
+	switch (line) {
+	case 0:
+		sprintf(hud_buf, "frame %5.2f ms present %4.2f", MS(PERF_FRAME_NS), MS(PERF_PRESENT_NS));
+		break;
+	case 1:
+		sprintf(hud_buf, "blits %4u px %6uk glyphs %u", (unsigned)last[PERF_BLITS],
+			(unsigned)(last[PERF_PIXELS] / 1000), (unsigned)last[PERF_GLYPHS]);
+		break;
+	case 2:
+		sprintf(hud_buf, "surfaces %u rotozooms %u", (unsigned)last[PERF_SURFACES],
+			(unsigned)last[PERF_ROTOZOOMS]);
+		break;
+	case 3:
+		sprintf(hud_buf, "tiles %4.2f queue %4.2f audio %4.2f", MS(PERF_DEFERRED_NS),
+			MS(PERF_QUEUE_NS), MS(PERF_AUDIO_NS));
+		break;
+	default:
+		return NULL;
+	}
+	return hud_buf;
+}
+
+void perf_draw_hud(int x, int y){
+	const pixfmt *pf = pixfmt_video();
+	const char *text;
+	SDL_Rect r;
+	int w, h, i, n = 0, cols = 0;
+
+	if (!vram || !pf)
+		return;
+
+	// fondo oscuro del tamaño de la línea más larga
+	font_get_size(&w, &h);
+	while ((text = perf_hud_line(n)) != NULL) {
+		if ((int)strlen(text) > cols)
+			cols = (int)strlen(text);
+		n++;
+	}
+	r.x = (Sint16)(x - 2);
+	r.y = (Sint16)(y - 2);
+	r.w = (Uint16)((cols - 1) * w + h + 4);
+	r.h = (Uint16)(n * (w + 2) + 2);
+	fill_rect(vram, &r, pixfmt_pack(pf, 0, 0, 0));
+
+	// la fuente incorporada usa `ancho` como alto de línea (ver caracter)
+	for (i = 0; i < n; i++)
+		print_f(x, y + i * (w + 2), pixfmt_pack(pf, 255, 255, 0), "%s", perf_hud_line(i));
+}
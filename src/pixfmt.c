@@ -0,0 +1,94 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <SDL/SDL.h>
+#include <types.h>
+#include <pixfmt.h>
+
+
+static pixfmt video_fmt;
+static int video_ok = 0;
+
+
+/*
+  Tablas de un canal con las fórmulas de SDL 1.2: empaquetar pierde los
+  bits bajos y desempaquetar repite los altos en los huecos.
+  */
+static void build_channel(u32 *pack, u8 *expand, u8 shift, u8 loss){
+	int v, s = 8 - (loss << 1);
+
+	for (v = 0; v < 256; v++) {
+		pack[v] = loss < 8 ? (u32)(v >> loss) << shift : 0;
+
+		if (loss >= 8 || v >= (256 >> loss))
+			expand[v] = 0;
+		else if (s > 0)
+			expand[v] = (u8)((v << loss) + (v >> s));
+		else
+			expand[v] = (u8)((v << loss) | (v << loss >> (8 - loss)));
+	}
+}
+
+void pixfmt_init(pixfmt *pf, SDL_PixelFormat *fmt){
+	pf->format = fmt;
+	pf->bpp = fmt->BytesPerPixel;
+	pf->rmask = fmt->Rmask;
+	pf->gmask = fmt->Gmask;
+	pf->bmask = fmt->Bmask;
+	pf->amask = fmt->Amask;
+	pf->rshift = fmt->Rshift;
+	pf->gshift = fmt->Gshift;
+	pf->bshift = fmt->Bshift;
+
+	if (fmt->palette) {
+		pf->kind = PIXFMT_PALETTE;
+		return;
+	}
+	if (fmt->BytesPerPixel == 4 && fmt->Rmask == 0xff0000 &&
+			fmt->Gmask == 0xff00 && fmt->Bmask == 0xff) {
+		pf->kind = PIXFMT_ARGB8888;
+		return;
+	}
+	if (fmt->BytesPerPixel == 2 && fmt->Rmask == 0xf800 &&
+			fmt->Gmask == 0x07e0 && fmt->Bmask == 0x001f) {
+		pf->kind = PIXFMT_RGB565;
+		return;
+	}
+
+	pf->kind = PIXFMT_GENERIC;
+	build_channel(pf->pack[0], pf->expand[0], fmt->Rshift, fmt->Rloss);
+	build_channel(pf->pack[1], pf->expand[1], fmt->Gshift, fmt->Gloss);
+	build_channel(pf->pack[2], pf->expand[2], fmt->Bshift, fmt->Bloss);
+}
+
+
+void pixfmt_video_update(SDL_PixelFormat *fmt){
+	if (!fmt) {
+		video_ok = 0;
+		return;
+	}
+	pixfmt_init(&video_fmt, fmt);
+	video_ok = 1;
+}
+
+const pixfmt *pixfmt_video(){
+	return video_ok ? &video_fmt : NULL;
+}
+
+const pixfmt *pixfmt_get(SDL_PixelFormat *fmt, pixfmt *scratch){
+	// por contenido: cada superficie tiene su propio SDL_PixelFormat
+	if (video_ok && !fmt->palette && fmt->BytesPerPixel == video_fmt.bpp &&
+			fmt->Rmask == video_fmt.rmask && fmt->Gmask == video_fmt.gmask &&
+			fmt->Bmask == video_fmt.bmask && fmt->Amask == video_fmt.amask)
+		return &video_fmt;
+
+	pixfmt_init(scratch, fmt);
+	return scratch;
+}
@@ -0,0 +1,251 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <present.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PRESENT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PRESENT_NEON 1
+#endif
+
+
+// filas intermedias de EPX a 4x
+static u32 *epx_tmp = NULL;
+static int epx_tmp_len = 0;
+
+
+#define ROW(s, y) ((u32*)((u8*)(s)->pixels + (y) * (s)->pitch))
+
+
+/*
+  Vecino más cercano de una fila: cada píxel se repite `scale` veces.
+  */
+static void nearest_row(u32 *out, const u32 *in, int n, int scale){
+	int i = 0, k;
+
+#if defined(PRESENT_SSE2)
+	if (scale == 2) {
+		for (; i + 4 <= n; i += 4, out += 8) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+			_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi32(v, v));
+			_mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi32(v, v));
+		}
+	} else if (scale == 3) {
+		for (; i + 4 <= n; i += 4, out += 12) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+			_mm_storeu_si128((__m128i*)out, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+			_mm_storeu_si128((__m128i*)(out + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+			_mm_storeu_si128((__m128i*)(out + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+		}
+	} else if (scale == 4) {
+		for (; i + 4 <= n; i += 4, out += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+			_mm_storeu_si128((__m128i*)out, _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 0, 0)));
+			_mm_storeu_si128((__m128i*)(out + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_storeu_si128((__m128i*)(out + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+			_mm_storeu_si128((__m128i*)(out + 12), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+	}
+#elif defined(PRESENT_NEON)
+	if (scale == 2) {
+		for (; i + 4 <= n; i += 4, out += 8) {
+			uint32x4_t v = vld1q_u32(in + i);
+			uint32x4x2_t z = vzipq_u32(v, v);
+			vst1q_u32(out, z.val[0]);
+			vst1q_u32(out + 4, z.val[1]);
+		}
+	} else if (scale == 4) {
+		for (; i + 4 <= n; i += 4, out += 16) {
+			uint32x4_t v = vld1q_u32(in + i);
+			vst1q_u32(out, vdupq_n_u32(vgetq_lane_u32(v, 0)));
+			vst1q_u32(out + 4, vdupq_n_u32(vgetq_lane_u32(v, 1)));
+			vst1q_u32(out + 8, vdupq_n_u32(vgetq_lane_u32(v, 2)));
+			vst1q_u32(out + 12, vdupq_n_u32(vgetq_lane_u32(v, 3)));
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		for (k = 0; k < scale; k++)
+			*out++ = in[i];
+}
+
+/*
+  Scanline: cada canal a la mitad. Se asume que cada canal ocupa un byte,
+  como en todos los formatos de 32 bits habituales.
+  */
+static void darken_row(u32 *row, int n){
+	int i = 0;
+
+#if defined(PRESENT_SSE2)
+	__m128i m = _mm_set1_epi32(0x7f7f7f7f);
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(row + i));
+		_mm_storeu_si128((__m128i*)(row + i), _mm_and_si128(_mm_srli_epi32(v, 1), m));
+	}
+#elif defined(PRESENT_NEON)
+	for (; i + 4 <= n; i += 4)
+		vst1q_u32(row + i, vreinterpretq_u32_u8(vshrq_n_u8(vreinterpretq_u8_u32(vld1q_u32(row + i)), 1)));
+#endif
+
+	for (; i < n; i++)
+		row[i] = (row[i] >> 1) & 0x7f7f7f7f;
+}
+
+
+/*
+  EPX de un píxel. B arriba, D izquierda, F derecha, H abajo; los colores se
+  comparan sin el byte de relleno.
+  */
+static void epx_pixel(u32 *o0, u32 *o1, u32 B, u32 D, u32 E, u32 F, u32 H, u32 mask){
+	int db = !((D ^ B) & mask), bf = !((B ^ F) & mask);
+	int dh = !((D ^ H) & mask), hf = !((H ^ F) & mask);
+
+	o0[0] = (db && !bf && !dh) ? D : E;
+	o0[1] = (bf && !db && !hf) ? F : E;
+	o1[0] = (dh && !db && !hf) ? D : E;
+	o1[1] = (hf && !dh && !bf) ? F : E;
+}
+
+/*
+  Genera las dos filas de salida de EPX para los píxeles [x0, x1) de la fila
+  `cur`. `o0` y `o1` apuntan a la salida del píxel x0.
+  */
+static void epx_row(u32 *o0, u32 *o1, const u32 *up, const u32 *cur, const u32 *dn,
+		int x0, int x1, int w, u32 mask){
+	int x = x0;
+
+	// borde izquierdo: el vecino D se repite
+	if (x == 0 && x < x1) {
+		epx_pixel(o0, o1, up[0], cur[0], cur[0], w > 1 ? cur[1] : cur[0], dn[0], mask);
+		x++;
+	}
+
+#if defined(PRESENT_SSE2)
+	{
+		__m128i m = _mm_set1_epi32(mask), z = _mm_setzero_si128();
+		for (; x + 4 <= x1 && x + 4 < w; x += 4) {
+			__m128i E = _mm_loadu_si128((const __m128i*)(cur + x));
+			__m128i B = _mm_loadu_si128((const __m128i*)(up + x));
+			__m128i H = _mm_loadu_si128((const __m128i*)(dn + x));
+			__m128i D = _mm_loadu_si128((const __m128i*)(cur + x - 1));
+			__m128i F = _mm_loadu_si128((const __m128i*)(cur + x + 1));
+			__m128i db = _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(D, B), m), z);
+			__m128i bf = _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(B, F), m), z);
+			__m128i dh = _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(D, H), m), z);
+			__m128i hf = _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(H, F), m), z);
+			__m128i c0 = _mm_andnot_si128(_mm_or_si128(bf, dh), db);
+			__m128i c1 = _mm_andnot_si128(_mm_or_si128(db, hf), bf);
+			__m128i c2 = _mm_andnot_si128(_mm_or_si128(db, hf), dh);
+			__m128i c3 = _mm_andnot_si128(_mm_or_si128(dh, bf), hf);
+			__m128i e0 = _mm_or_si128(_mm_and_si128(c0, D), _mm_andnot_si128(c0, E));
+			__m128i e1 = _mm_or_si128(_mm_and_si128(c1, F), _mm_andnot_si128(c1, E));
+			__m128i e2 = _mm_or_si128(_mm_and_si128(c2, D), _mm_andnot_si128(c2, E));
+			__m128i e3 = _mm_or_si128(_mm_and_si128(c3, F), _mm_andnot_si128(c3, E));
+			u32 *p0 = o0 + (x - x0) * 2, *p1 = o1 + (x - x0) * 2;
+
+			_mm_storeu_si128((__m128i*)p0, _mm_unpacklo_epi32(e0, e1));
+			_mm_storeu_si128((__m128i*)(p0 + 4), _mm_unpackhi_epi32(e0, e1));
+			_mm_storeu_si128((__m128i*)p1, _mm_unpacklo_epi32(e2, e3));
+			_mm_storeu_si128((__m128i*)(p1 + 4), _mm_unpackhi_epi32(e2, e3));
+		}
+	}
+#endif
+
+	for (; x < x1; x++) {
+		u32 F = x + 1 < w ? cur[x + 1] : cur[x];
+		epx_pixel(o0 + (x - x0) * 2, o1 + (x - x0) * 2, up[x], cur[x - 1], cur[x], F, dn[x], mask);
+	}
+}
+
+
+int present_scale(SDL_Surface *src, SDL_Surface *dst, const SDL_Rect *rect, int scale, int flags){
+	int x0 = 0, y0 = 0, x1, y1, n, y, k, epx;
+	u32 mask;
+
+	if (!src || !dst || scale < 1 || scale > PRESENT_MAX_SCALE)
+		return -1;
+	if (src->format->BytesPerPixel != 4 || dst->format->BytesPerPixel != 4)
+		return -1;
+	if (dst->w < src->w * scale || dst->h < src->h * scale)
+		return -1;
+
+	x1 = src->w;
+	y1 = src->h;
+	if (rect) {
+		if (rect->x > x0) x0 = rect->x;
+		if (rect->y > y0) y0 = rect->y;
+		if (rect->x + rect->w < x1) x1 = rect->x + rect->w;
+		if (rect->y + rect->h < y1) y1 = rect->y + rect->h;
+	}
+	if (x0 >= x1 || y0 >= y1)
+		return 0;
+
+	n = x1 - x0;
+	epx = (flags & PRESENT_EPX) && (scale == 2 || scale == 4);
+	mask = src->format->Rmask | src->format->Gmask | src->format->Bmask;
+
+	if (epx && scale == 4 && epx_tmp_len < n * 4) {
+		u32 *t = (u32*)realloc(epx_tmp, n * 4 * sizeof(u32));
+		if (!t)
+			return -1;
+		epx_tmp = t;
+		epx_tmp_len = n * 4;
+	}
+
+	if (SDL_MUSTLOCK(src))
+		SDL_LockSurface(src);
+	if (SDL_MUSTLOCK(dst))
+		SDL_LockSurface(dst);
+
+	for (y = y0; y < y1; y++) {
+		const u32 *cur = ROW(src, y);
+		u32 *out = ROW(dst, y * scale) + x0 * scale;
+
+		if (epx) {
+			const u32 *up = ROW(src, y > 0 ? y - 1 : y);
+			const u32 *dn = ROW(src, y + 1 < src->h ? y + 1 : y);
+
+			if (scale == 2) {
+				epx_row(out, ROW(dst, y * 2 + 1) + x0 * 2, up, cur, dn, x0, x1, src->w, mask);
+			} else {
+				// 4x: EPX a filas intermedias y después 2x por vecino más cercano
+				u32 *t0 = epx_tmp, *t1 = epx_tmp + n * 2;
+				epx_row(t0, t1, up, cur, dn, x0, x1, src->w, mask);
+				nearest_row(out, t0, n * 2, 2);
+				memcpy(ROW(dst, y * 4 + 1) + x0 * 4, out, n * 4 * sizeof(u32));
+				nearest_row(ROW(dst, y * 4 + 2) + x0 * 4, t1, n * 2, 2);
+				memcpy(ROW(dst, y * 4 + 3) + x0 * 4, ROW(dst, y * 4 + 2) + x0 * 4, n * 4 * sizeof(u32));
+			}
+		} else {
+			// la fila se genera una vez y se copia al resto del bloque
+			nearest_row(out, cur + x0, n, scale);
+			for (k = 1; k < scale; k++)
+				memcpy(ROW(dst, y * scale + k) + x0 * scale, out, n * scale * sizeof(u32));
+		}
+
+		if ((flags & PRESENT_SCANLINES) && scale > 1)
+			darken_row(ROW(dst, y * scale + scale - 1) + x0 * scale, n * scale);
+	}
+
+	if (SDL_MUSTLOCK(dst))
+		SDL_UnlockSurface(dst);
+	if (SDL_MUSTLOCK(src))
+		SDL_UnlockSurface(src);
+
+	return 0;
+}
@@ -0,0 +1,535 @@
+/*
+ * libGPP-Engine - A lightweight static game engine for retro consoles.
+ * Copyright (c) 2025 Andrés Ruiz Pérez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 or version 3.
+ * https://www.gnu.org/licenses/
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+#include <types.h>
+#include <SFont.h>
+#include <dirty_rect.h>
+#include <fill.h>
+#include <font.h>
+#include <cmdlist.h>
+#include <render_queue.h>
+#include <perf.h>
+
+
+enum {
+	RQ_BLIT,
+	RQ_SFONT,
+	RQ_FILL,
+	RQ_TEXT,
+	RQ_PRIM,
+	RQ_CALL
+};
+
+typedef struct {
+	int type;
+	SDL_Surface *src;		// superficie del blit o de la fuente
+	SDL_Rect srect;			// zona del blit, recortada igual que bounds
+	SDL_Rect bounds;		// caja en el destino, ya recortada
+	int x1, y1, x2, y2;		// puntos de la primitiva; posición y celda del texto
+	int kind;				// primitiva CMDLIST_*
+	Uint8 alpha;
+	u32 color;
+	const SFont_Font *font;
+	int text;				// desplazamiento en rec.text
+	render_call_func fn;
+	void *ctx;
+} rq_cmd;
+
+typedef struct {
+	Uint64 key;
+	int cmd;
+} rq_entry;
+
+// superficie -> número por orden de aparición; gen marca las entradas del frame
+typedef struct {
+	const void *ptr;
+	int id;
+	unsigned gen;
+} rq_slot;
+
+
+static SDL_Surface *target = NULL;
+static int recording = 0;
+static int routed_layer = 0;
+static render_cull_func cull_fn = NULL;
+static void *cull_ctx = NULL;
+static render_queue_stats stats;
+
+static rq_cmd *cmds = NULL;
+static rq_entry *entries = NULL, *scratch = NULL;
+static int cmd_count = 0, cmd_cap = 0, entry_cap = 0, scratch_cap = 0;
+static cmdlist rec;			// textos, superficies retenidas y contextos
+
+// tramo actual de cada capa; sube con cada orden sin superficie
+static int segment[256];
+static Uint8 after_barrier[256];
+
+static rq_slot *slots = NULL;
+static int slot_cap = 0, source_count = 0;
+static unsigned gen = 0;
+
+
+int render_queue_begin(SDL_Surface *dst){
+	if (recording)
+		render_queue_end();
+	if (!dst || !dst->format)
+		return -1;
+
+	target = dst;
+	recording = 1;
+	cmd_count = 0;
+	source_count = 0;
+	gen++;
+	memset(segment, 0, sizeof(segment));
+	memset(after_barrier, 0, sizeof(after_barrier));
+	memset(&stats, 0, sizeof(stats));
+	return 0;
+}
+
+SDL_Surface *render_queue_target(){
+	return recording ? target : NULL;
+}
+
+void render_queue_set_layer(int layer){
+	routed_layer = layer < 0 ? 0 : layer > 255 ? 255 : layer;
+}
+
+int render_queue_layer(){
+	return routed_layer;
+}
+
+void render_queue_set_cull(render_cull_func fn, void *ctx){
+	cull_fn = fn;
+	cull_ctx = ctx;
+}
+
+void render_queue_get_stats(render_queue_stats *out){
+	*out = stats;
+}
+
+int render_queue_keep(SDL_Surface *s){
+	if (!recording || !s)
+		return -1;
+	return cmdlist_keep(&rec, s) < 0 ? -1 : 0;
+}
+
+void *render_queue_alloc(int size){
+	return recording ? cmdlist_alloc(&rec, size) : NULL;
+}
+
+
+static void slot_put(rq_slot *table, int cap, const void *p, int id){
+	unsigned h = (unsigned)(((size_t)p >> 4) * 2654435761u) & (cap - 1);
+
+	while (table[h].gen == gen)
+		h = (h + 1) & (cap - 1);
+	table[h].ptr = p;
+	table[h].id = id;
+	table[h].gen = gen;
+}
+
+/*
+  Número de la superficie en este frame. Si no hay memoria para la tabla se
+  devuelve el máximo: el orden sigue siendo correcto, solo agrupa peor.
+  */
+static int source_id(const void *p){
+	unsigned h;
+	int i;
+
+	if (!p)
+		return 0;
+
+	if ((source_count + 1) * 2 > slot_cap) {
+		int cap = slot_cap ? slot_cap * 2 : 256;
+		rq_slot *t = (rq_slot*)calloc(cap, sizeof(rq_slot));
+		if (!t)
+			return RENDER_KEY_SOURCE_MAX;
+		for (i = 0; i < slot_cap; i++)
+			if (slots[i].gen == gen)
+				slot_put(t, cap, slots[i].ptr, slots[i].id);
+		free(slots);
+		slots = t;
+		slot_cap = cap;
+	}
+
+	h = (unsigned)(((size_t)p >> 4) * 2654435761u) & (slot_cap - 1);
+	while (slots[h].gen == gen) {
+		if (slots[h].ptr == p)
+			return slots[h].id;
+		h = (h + 1) & (slot_cap - 1);
+	}
+
+	if (source_count < RENDER_KEY_SOURCE_MAX)
+		source_count++;
+	slots[h].ptr = p;
+	slots[h].id = source_count;
+	slots[h].gen = gen;
+	return source_count;
+}
+
+/*
+  Clave de la orden. Las que no tienen superficie (rellenos, primitivas,
+  textos y llamadas) no se pueden agrupar: abren un tramo nuevo en su capa,
+  así que quedan detrás de todo lo grabado antes y delante de lo posterior.
+  Las seguidas comparten tramo y clave, y el orden estable las respeta.
+  */
+static Uint64 make_key(int layer, Uint8 alpha, const void *source, int depth){
+	Uint64 blend = alpha < 255 ? RENDER_BLEND_ALPHA : RENDER_BLEND_NONE;
+
+	if (layer < 0) layer = 0;
+	if (layer > 255) layer = 255;
+	if (depth < 0) depth = 0;
+	if (depth > 0xffff) depth = 0xffff;
+
+	if (!source) {
+		if (!after_barrier[layer] && segment[layer] < RENDER_KEY_SEGMENT_MAX)
+			segment[layer]++;
+		after_barrier[layer] = 1;
+		depth = 0;
+	} else {
+		after_barrier[layer] = 0;
+	}
+
+	return ((Uint64)layer << RENDER_KEY_LAYER_SHIFT) |
+		((Uint64)segment[layer] << RENDER_KEY_SEGMENT_SHIFT) |
+		(blend << RENDER_KEY_BLEND_SHIFT) |
+		((Uint64)(alpha < 255 ? alpha : 0) << RENDER_KEY_ALPHA_SHIFT) |
+		((Uint64)source_id(source) << RENDER_KEY_SOURCE_SHIFT) |
+		(Uint64)depth;
+}
+
+/*
+  Recorta la caja [x1,x2) x [y1,y2) al destino, pasa el descarte propio y
+  reserva la orden. Devuelve NULL si la orden no se dibuja.
+  */
+static rq_cmd *new_cmd(int type, int x1, int y1, int x2, int y2){
+	SDL_Rect b;
+	void *p;
+	rq_cmd *c;
+
+	if (!recording)
+		return NULL;
+	stats.commands++;
+
+	if (!cmdlist_clip(target, &x1, &y1, &x2, &y2)) {
+		stats.culled++;
+		return NULL;
+	}
+	b.x = (Sint16)x1;
+	b.y = (Sint16)y1;
+	b.w = (Uint16)(x2 - x1);
+	b.h = (Uint16)(y2 - y1);
+	if (cull_fn && !cull_fn(&b, cull_ctx)) {
+		stats.culled++;
+		return NULL;
+	}
+
+	if (!(p = cmdlist_grow(cmds, &cmd_cap, cmd_count + 1, sizeof(rq_cmd))))
+		return NULL;
+	cmds = (rq_cmd*)p;
+	if (!(p = cmdlist_grow(entries, &entry_cap, cmd_count + 1, sizeof(rq_entry))))
+		return NULL;
+	entries = (rq_entry*)p;
+	if (!(p = cmdlist_grow(scratch, &scratch_cap, cmd_count + 1, sizeof(rq_entry))))
+		return NULL;
+	scratch = (rq_entry*)p;
+
+	c = &cmds[cmd_count];
+	memset(c, 0, sizeof(*c));
+	c->type = type;
+	c->bounds = b;
+	c->alpha = 255;
+	return c;
+}
+
+static void push(rq_cmd *c, int layer, const void *source, int depth){
+	entries[cmd_count].key = make_key(layer, c->alpha, source, depth);
+	entries[cmd_count].cmd = cmd_count;
+	cmd_count++;
+}
+
+
+void render_queue_blit(SDL_Surface *src, const SDL_Rect *srect, int x, int y, int layer, int depth){
+	render_queue_blit_alpha(src, srect, x, y, 255, layer, depth);
+}
+
+void render_queue_blit_alpha(SDL_Surface *src, const SDL_Rect *srect, int x, int y,
+		Uint8 alpha, int layer, int depth){
+	int sx1 = 0, sy1 = 0, sx2, sy2;
+	rq_cmd *c;
+
+	if (!recording || !src || alpha == 0)
+		return;
+
+	// recorte en el origen; el del destino lo hace new_cmd
+	sx2 = src->w;
+	sy2 = src->h;
+	if (srect) {
+		sx1 = srect->x;
+		sy1 = srect->y;
+		sx2 = srect->x + srect->w;
+		sy2 = srect->y + srect->h;
+		if (sx1 < 0) { x -= sx1; sx1 = 0; }
+		if (sy1 < 0) { y -= sy1; sy1 = 0; }
+		if (sx2 > src->w) sx2 = src->w;
+		if (sy2 > src->h) sy2 = src->h;
+	}
+	if (sx1 >= sx2 || sy1 >= sy2)
+		return;
+
+	c = new_cmd(RQ_BLIT, x, y, x + sx2 - sx1, y + sy2 - sy1);
+	if (!c || cmdlist_keep(&rec, src) < 0)
+		return;
+	// SDL_LowerBlit necesita las dos zonas ya recortadas y del mismo tamaño
+	c->src = src;
+	c->srect.x = (Sint16)(sx1 + c->bounds.x - x);
+	c->srect.y = (Sint16)(sy1 + c->bounds.y - y);
+	c->srect.w = c->bounds.w;
+	c->srect.h = c->bounds.h;
+	c->alpha = alpha;
+	push(c, layer, src, depth);
+}
+
+void render_queue_sfont(const SFont_Font *font, int x, int y, const char *text, int layer, int depth){
+	rq_cmd *c;
+
+	if (!recording || !font || !text || !*text)
+		return;
+
+	c = new_cmd(RQ_SFONT, x, y, x + SFont_TextWidth(font, text), y + SFont_TextHeight(font));
+	if (!c || (c->text = cmdlist_text(&rec, text)) < 0 || cmdlist_keep(&rec, font->Surface) < 0)
+		return;
+	c->src = font->Surface;
+	c->font = font;
+	c->x1 = x;
+	c->y1 = y;
+	push(c, layer, font->Surface, depth);
+}
+
+void render_queue_text(int x, int y, const char *text, u32 color, int layer, int depth){
+	rq_cmd *c;
+	int cw, ch;
+
+	if (!recording || !text || !*text)
+		return;
+
+	// igual que caracter(): la celda mide ch de ancho y cw de alto, avanza cw
+	font_get_size(&cw, &ch);
+	c = new_cmd(RQ_TEXT, x, y, x + ((int)strlen(text) - 1) * cw + ch, y + cw);
+	if (!c || (c->text = cmdlist_text(&rec, text)) < 0)
+		return;
+	c->x1 = x;
+	c->y1 = y;
+	c->x2 = cw;
+	c->y2 = ch;
+	c->color = color;
+	push(c, layer, NULL, depth);
+}
+
+void render_queue_fill(const SDL_Rect *rect, u32 color, int layer, int depth){
+	rq_cmd *c;
+
+	if (!recording)
+		return;
+	if (rect)
+		c = new_cmd(RQ_FILL, rect->x, rect->y, rect->x + rect->w, rect->y + rect->h);
+	else
+		c = new_cmd(RQ_FILL, 0, 0, target->w, target->h);
+	if (!c)
+		return;
+	c->color = color;
+	push(c, layer, NULL, depth);
+}
+
+static void record_prim(int kind, int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth){
+	int bx1, by1, bx2, by2;
+	rq_cmd *c;
+
+	cmdlist_prim_bounds(kind, x1, y1, x2, y2, &bx1, &by1, &bx2, &by2);
+	if (!(c = new_cmd(RQ_PRIM, bx1, by1, bx2, by2)))
+		return;
+	c->kind = kind;
+	c->x1 = x1;
+	c->y1 = y1;
+	c->x2 = x2;
+	c->y2 = y2;
+	c->color = rgba;
+	push(c, layer, NULL, depth);
+}
+
+void render_queue_line(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth){
+	record_prim(CMDLIST_LINE, x1, y1, x2, y2, rgba, layer, depth);
+}
+
+void render_queue_rect(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth){
+	record_prim(CMDLIST_RECT, x1, y1, x2, y2, rgba, layer, depth);
+}
+
+void render_queue_box(int x1, int y1, int x2, int y2, u32 rgba, int layer, int depth){
+	record_prim(CMDLIST_BOX, x1, y1, x2, y2, rgba, layer, depth);
+}
+
+void render_queue_circle(int x, int y, int r, u32 rgba, int layer, int depth){
+	record_prim(CMDLIST_CIRCLE, x, y, r, 0, rgba, layer, depth);
+}
+
+void render_queue_filled_circle(int x, int y, int r, u32 rgba, int layer, int depth){
+	record_prim(CMDLIST_FILLED_CIRCLE, x, y, r, 0, rgba, layer, depth);
+}
+
+void render_queue_call(render_call_func fn, void *ctx, const SDL_Rect *bounds, int layer, int depth){
+	rq_cmd *c;
+
+	if (!recording || !fn)
+		return;
+	if (bounds)
+		c = new_cmd(RQ_CALL, bounds->x, bounds->y, bounds->x + bounds->w, bounds->y + bounds->h);
+	else
+		c = new_cmd(RQ_CALL, 0, 0, target->w, target->h);
+	if (!c)
+		return;
+	c->fn = fn;
+	c->ctx = ctx;
+	push(c, layer, NULL, depth);
+}
+
+
+/*
+  Radix sort LSD de 8 bits, estable. Un solo recorrido saca los histogramas
+  de los 8 bytes y solo se hacen las pasadas de los bytes que varían: con
+  pocas capas y hojas suelen ser 2 o 3 en lugar de 8.
+  */
+static rq_entry *radix_sort(rq_entry *a, rq_entry *tmp, int n){
+	static int hist[8][256];
+	Uint64 all_or = 0, all_and = ~(Uint64)0, k;
+	int i, b, sum, t;
+	rq_entry *swap;
+
+	memset(hist, 0, sizeof(hist));
+	for (i = 0; i < n; i++) {
+		k = a[i].key;
+		all_or |= k;
+		all_and &= k;
+		for (b = 0; b < 8; b++)
+			hist[b][(k >> (b * 8)) & 0xff]++;
+	}
+
+	for (b = 0; b < 8; b++) {
+		if (!(((all_or ^ all_and) >> (b * 8)) & 0xff))
+			continue;
+
+		sum = 0;
+		for (i = 0; i < 256; i++) {
+			t = hist[b][i];
+			hist[b][i] = sum;
+			sum += t;
+		}
+		for (i = 0; i < n; i++)
+			tmp[hist[b][(a[i].key >> (b * 8)) & 0xff]++] = a[i];
+
+		swap = a;
+		a = tmp;
+		tmp = swap;
+		stats.sort_passes++;
+	}
+	return a;
+}
+
+static void run_command(rq_cmd *c){
+	SDL_Rect s, d;
+	const char *text;
+	int k;
+
+	switch (c->type) {
+	case RQ_BLIT:
+		s = c->srect;
+		d = c->bounds;
+		SDL_LowerBlit(c->src, &s, target, &d);
+		PERF_COUNT(PERF_BLITS, 1);
+		PERF_COUNT(PERF_PIXELS, s.w * s.h);
+		break;
+	case RQ_SFONT:
+		SFont_Write(target, c->font, c->x1, c->y1, rec.text + c->text);
+		break;
+	case RQ_FILL:
+		fill_rect(target, &c->bounds, c->color);
+		break;
+	case RQ_TEXT:
+		text = rec.text + c->text;
+		for (k = 0; text[k]; k++)
+			caracter_surface(target, c->x1 + k * c->x2, c->y1, c->x2, c->y2, text[k], c->color);
+		PERF_COUNT(PERF_GLYPHS, k);
+		break;
+	case RQ_PRIM:
+		cmdlist_prim_draw(target, c->kind, c->x1, c->y1, c->x2, c->y2, 0, 0, c->color);
+		break;
+	case RQ_CALL:
+		c->fn(target, c->ctx);
+		break;
+	}
+}
+
+int render_queue_end(){
+	rq_entry *sorted;
+	rq_cmd *c;
+	SDL_Surface *src = NULL;
+	Uint64 run = ~(Uint64)0;
+	Uint32 saved_flags = 0;
+	Uint8 saved_alpha = 255;
+	int i, changed = 0;
+	PERF_TIMER_BEGIN(PERF_QUEUE_NS);
+
+	if (!recording)
+		return 0;
+	recording = 0;
+
+	sorted = radix_sort(entries, scratch, cmd_count);
+
+	for (i = 0; i < cmd_count; i++) {
+		c = &cmds[sorted[i].cmd];
+
+		// tramo nuevo: misma capa, tramo de capa, mezcla y superficie hasta el siguiente cambio
+		if ((sorted[i].key >> RENDER_KEY_SOURCE_SHIFT) != run) {
+			run = sorted[i].key >> RENDER_KEY_SOURCE_SHIFT;
+			stats.runs++;
+
+			if (changed)
+				SDL_SetAlpha(src, saved_flags, saved_alpha);
+			changed = 0;
+			src = c->src;
+
+			// SDL_SetAlpha decodifica el RLE: una vez por tramo, no por orden
+			if (src && c->alpha < 255 &&
+					(!(src->flags & SDL_SRCALPHA) || src->format->alpha != c->alpha)) {
+				Uint32 rle = (src->flags & SDL_RLEACCELOK) ? SDL_RLEACCEL : 0;
+				saved_flags = (src->flags & SDL_SRCALPHA) | rle;
+				saved_alpha = src->format->alpha;
+				SDL_SetAlpha(src, SDL_SRCALPHA | rle, c->alpha);
+				changed = 1;
+			}
+		}
+
+		// la orden marca su caja antes de dibujar; lo que marquen SDL_gfx,
+		// SFont o fill_rect ya queda dentro y se descarta al momento
+		dirty_rect_add(target, &c->bounds);
+		run_command(c);
+		stats.drawn++;
+	}
+	if (changed)
+		SDL_SetAlpha(src, saved_flags, saved_alpha);
+
+	cmdlist_reset(&rec);
+	cmd_count = 0;
+	PERF_TIMER_END(PERF_QUEUE_NS);
+	return stats.drawn;
+}
@@ -18,6 +18,10 @@
 #include <SDL_gfxPrimitives.h>
 
 #include <video.h>
+#include <dirty_rect.h>
+#include <fill.h>
+#include <gradient.h>
+#include <perf.h>
 
 
 
@@ -40,6 +44,7 @@ SDL_Surface *load_img(const char *file){
 		return NULL;
 	}
 	temp = SDL_DisplayFormat(temp);
+	PERF_COUNT(PERF_SURFACES, 1);
 	return temp;
 }
 
@@ -76,6 +81,9 @@ void draw_surface(SDL_Surface *src, int x, int y){
 
 	SDL_Rect rect={x,y,0,0};
 	SDL_BlitSurface(src,NULL,vram,&rect);
+	dirty_rect_add(vram,&rect);
+	PERF_COUNT(PERF_BLITS, 1);
+	PERF_COUNT(PERF_PIXELS, rect.w * rect.h);
 }
 
 
@@ -104,6 +112,7 @@ SDL_Surface *create_surface(int w, int h, Uint32 flag){
 	}
 
 	temp = SDL_DisplayFormat(temp);
+	PERF_COUNT(PERF_SURFACES, 1);
 
 	return temp;
 }
@@ -124,22 +133,8 @@ SDL_Surface *create_surface(int w, int h, Uint32 flag){
 void fill_texture(SDL_Surface *src, int w, int h, Uint32 c1, Uint32 c2) {
     if (!src || src->format->BytesPerPixel != 4) return;
 
-    if (SDL_MUSTLOCK(src)) SDL_LockSurface(src);
-
-    Uint32 *pixels = (Uint32 *)src->pixels;
-    int pitch = src->pitch / 4;  // Número de Uint32 por fila
-
-    int y;
-    int x;
 
-    for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
-            Uint32 color = ((x + y) % 2 == 0) ? c1 : c2;
-            pixels[y * pitch + x] = color;
-        }
-    }
-
-    if (SDL_MUSTLOCK(src)) SDL_UnlockSurface(src);
+    fill_checker(src, w, h, c1, c2);
 }
 
 
@@ -208,32 +203,7 @@ void AplyAlpha(SDL_Surface *src, u8 alpha)
  * @param color2 Color final del gradiente (en formato ARGB).
  */
 void fill_horizontal_gradient(SDL_Surface *surface, Uint32 color1, Uint32 color2) {
-    if (SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
-
-    int x;
-
-    for (x = 0; x < surface->w; x++) {
-        float t = (float)x / (surface->w - 1); // Valor de interpolación (0 a 1)
-        
-        Uint8 r1, g1, b1, r2, g2, b2;
-        SDL_GetRGB(color1, surface->format, &r1, &g1, &b1);
-        SDL_GetRGB(color2, surface->format, &r2, &g2, &b2);
-
-        Uint8 r = (Uint8)((1 - t) * r1 + t * r2);
-        Uint8 g = (Uint8)((1 - t) * g1 + t * g2);
-        Uint8 b = (Uint8)((1 - t) * b1 + t * b2);
-
-        Uint32 blended_color = SDL_MapRGB(surface->format, r, g, b);
-
-        int y;
-        Uint32 *p = (Uint32*)surface->pixels;
-        for (y = 0; y < surface->h; y++) {
-            //pixel( x, y, blended_color);
-            p[y*(surface->w)+x] = blended_color;
-        }
-    }
-
-    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+    gradient_horizontal(surface, color1, color2);
 }
 
 
@@ -248,27 +218,7 @@ void fill_horizontal_gradient(SDL_Surface *surface, Uint32 color1, Uint32 color2
  * @param color2 Color final del gradiente (en formato ARGB).
  */
 void fill_vertical_gradient(SDL_Surface *surface, Uint32 color1, Uint32 color2) {
-    if (SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
-
-    // De rojo a azul
-    Uint8 r1 = 255, g1 = 0, b1 = 0;
-    Uint8 r2 = 0,   g2 = 0, b2 = 255;
-
-    int y;
-    int x;
-    Uint32 *p = (Uint32*)surface->pixels;
-    for (y = 0; y < surface->h; y++) {
-        float t = (float)y / (surface->h - 1);
-        Uint8 r = (Uint8)((1 - t) * r1 + t * r2);
-        Uint8 g = (Uint8)((1 - t) * g1 + t * g2);
-        Uint8 b = (Uint8)((1 - t) * b1 + t * b2);
-        Uint32 color = SDL_MapRGB(surface->format, r, g, b);
-        for (x = 0; x < surface->w; x++) {
-            p[y * surface->w + x] = color;
-        }
-    }
-
-    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+    gradient_vertical(surface, color1, color2);
 }
 
 
@@ -284,34 +234,7 @@ void fill_vertical_gradient(SDL_Surface *surface, Uint32 color1, Uint32 color2)
  * @param color2 Color de los bordes del gradiente (en formato ARGB).
  */
 void fill_radial_gradient(SDL_Surface *surface, Uint32 color1, Uint32 color2) {
-    if (SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
-
-    int cx = surface->w / 2;
-    int cy = surface->h / 2;
-    float max_dist = sqrt(cx * cx + cy * cy);
-    Uint32 *p = (Uint32*)surface->pixels;
-    int x,y;
-
-    for ( y = 0; y < surface->h; y++) {
-        for (x = 0; x < surface->w; x++) {
-            float dist = sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
-            float t = dist / max_dist;
-
-            Uint8 r1, g1, b1, r2, g2, b2;
-            SDL_GetRGB(color1, surface->format, &r1, &g1, &b1);
-            SDL_GetRGB(color2, surface->format, &r2, &g2, &b2);
-
-            Uint8 r = (Uint8)((1 - t) * r1 + t * r2);
-            Uint8 g = (Uint8)((1 - t) * g1 + t * g2);
-            Uint8 b = (Uint8)((1 - t) * b1 + t * b2);
-
-            Uint32 blended_color = SDL_MapRGB(surface->format, r, g, b);
-            //set_pixel(surface, x, y, blended_color);
-            p[y * surface->w + x] = blended_color;
-        }
-    }
-
-    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+    gradient_radial(surface, color1, color2);
 }
 
 
@@ -344,6 +267,7 @@ SDL_Surface *Load_Textura_From_Mem( u8 *buffer, int len)
     }
 
     out = SDL_DisplayFormat(out);
+    PERF_COUNT(PERF_SURFACES, 1);
     return out;
 }
 
@@ -372,6 +296,8 @@ SDL_Surface *rotozoom_init(SDL_Surface *src, double angle, double zoom){
         }
         
     //temp = SDL_DisplayFormat(temp);
+    PERF_COUNT(PERF_ROTOZOOMS, 1);
+    PERF_COUNT(PERF_SURFACES, 1);
 
     AplyTransparency(temp,0,0,0);
 
@@ -406,6 +332,7 @@ void set_surface_rotozoom(SDL_Surface *src, int x, int y){
 
     // Dibujar la imagen rotada en la pantalla
     SDL_BlitSurface(src, NULL, vram, &destRect);
+    dirty_rect_add(vram, &destRect);
 }
 
 
@@ -446,6 +373,7 @@ SDL_Surface *cut_surface(SDL_Surface *src, int x, int y, int w, int h) {
     );
 
     if (!cut) return NULL;
+    PERF_COUNT(PERF_SURFACES, 1);
 
     SDL_BlitSurface(src, &rect, cut, NULL);
     return cut;
@@ -10,10 +10,19 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL/SDL.h>
 #include <types.h>
 #include <video.h>
 #include <font.h>
+#include <dirty_rect.h>
+#include <job_pool.h>
+#include <anim.h>
+#include <fill.h>
+#include <pacer.h>
+#include <pixfmt.h>
+#include <perf.h>
 
 //vram 
 SDL_Surface *vram = NULL;
@@ -21,6 +30,17 @@ SDL_Surface *vram = NULL;
 //framebuffer
 u32 *fb = NULL;
 
+// presentación escalada: vram es el búfer interno y screen la ventana
+static SDL_Surface *screen = NULL;
+static int vscale = 1;
+static int vscale_flags = 0;
+
+// modo sin pantalla
+static int vflags = 0;
+static Uint64 frame_hash = 0;
+static Uint32 frame_count = 0;
+static char dump_pattern[256] = "frame_%05u.bmp";
+
 
 /**
  * @brief Inicializa el sistema con un mensaje opcional.
@@ -42,6 +62,14 @@ u32 *fb = NULL;
  *       cumplidos antes de llamarla.
  */
 int Init_Sistem(const char *msg){
+	const char *env = getenv("GPP_HEADLESS");
+
+	if(env && atoi(env))
+		vflags |= atoi(env) | VIDEO_HEADLESS;
+
+	// el driver dummy de SDL da una superficie en memoria y eventos vacíos
+	if(vflags & VIDEO_HEADLESS)
+		SDL_putenv("SDL_VIDEODRIVER=dummy");
 
 	if(SDL_Init(SDL_INIT_VIDEO|SDL_INIT_TIMER)<0){
 		printf("error: %s",SDL_GetError());
@@ -50,6 +78,8 @@ int Init_Sistem(const char *msg){
 
 	printf("\n%s\n",msg);
 	fontsize(8, 8);
+	job_pool_init(0);
+	pacer_set_enabled(!(vflags & VIDEO_UNPACED));
 
 	return 0;
 
@@ -75,7 +105,14 @@ int Init_Sistem(const char *msg){
  */
 int Set_Video(int width, int height){
 
-	vram = SDL_SetVideoMode(width, height, 32, SDL_HWSURFACE);
+	if(screen){
+		SDL_FreeSurface(vram);
+		screen = NULL;
+		vscale = 1;
+	}
+
+	vram = SDL_SetVideoMode(width, height, 32,
+		(vflags & VIDEO_HEADLESS) ? SDL_SWSURFACE : SDL_HWSURFACE);
 	if(!vram){
 		printf("error: %s\n",SDL_GetError());
 		return -1;
@@ -84,12 +121,63 @@ int Set_Video(int width, int height){
 	SDL_ShowCursor(SDL_FALSE);
 
 	fb = (u32*)vram->pixels;
+	frame_count = 0;
+	pixfmt_video_update(vram->format);
 
 	return 0;
 
 }
 
 
+/**
+ * @brief Configura el video con un búfer interno escalado a la ventana.
+ *
+ * @see video.h
+ */
+int Set_Video_Scaled(int width, int height, int scale, int flags){
+	SDL_Surface *s;
+
+	if(scale < 1 || scale > PRESENT_MAX_SCALE){
+		printf("error: unsupported scale %d\n", scale);
+		return -1;
+	}
+	if(scale == 1)
+		return Set_Video(width, height);
+
+	if(screen)
+		SDL_FreeSurface(vram);
+	screen = NULL;
+	vram = NULL;
+	fb = NULL;
+
+	s = SDL_SetVideoMode(width * scale, height * scale, 32,
+		(vflags & VIDEO_HEADLESS) ? SDL_SWSURFACE : SDL_HWSURFACE);
+	if(!s){
+		printf("error: %s\n",SDL_GetError());
+		return -1;
+	}
+
+	// mismo formato que la ventana para que el escalado sea una copia directa
+	vram = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, 32,
+		s->format->Rmask, s->format->Gmask, s->format->Bmask, 0);
+	if(!vram){
+		printf("error: %s\n",SDL_GetError());
+		return -1;
+	}
+
+	SDL_ShowCursor(SDL_FALSE);
+
+	screen = s;
+	vscale = scale;
+	vscale_flags = flags;
+	fb = (u32*)vram->pixels;
+	frame_count = 0;
+	pixfmt_video_update(vram->format);
+
+	return 0;
+}
+
+
 /**
  * @brief Obtiene las dimensiones de la resolución de video actual.
  *
@@ -126,6 +214,7 @@ void get_wh_video_mode(int *width, int *height){
  *       para evitar la pérdida de datos o daños a los archivos abiertos.
  */
 void shoutdown_sistem(){
+	job_pool_quit();
 	SDL_Quit();
 
 }
@@ -142,10 +231,154 @@ void shoutdown_sistem(){
  */
 void off_video(){
 	SDL_FreeSurface(vram);
+	vram = NULL;
+	pixfmt_video_update(NULL);
+	screen = NULL;
+	vscale = 1;
 	fb = NULL;
 }
 
 
+/*
+  FNV-1a de 64 bits sobre los píxeles visibles. En 32 bits se enmascaran los
+  canales para que el byte de relleno (que los blits no siempre escriben) no
+  cambie el resultado.
+  */
+static Uint64 hash_surface(SDL_Surface *s){
+	Uint64 h = 14695981039346656037ULL;
+	Uint32 mask, c;
+	int x, y, i, bpp = s->format->BytesPerPixel;
+	const u8 *row;
+
+	mask = s->format->Rmask | s->format->Gmask | s->format->Bmask;
+	for(y = 0; y < s->h; y++){
+		row = (const u8*)s->pixels + y * s->pitch;
+		if(bpp == 4){
+			for(x = 0; x < s->w; x++){
+				c = ((const Uint32*)row)[x] & mask;
+				for(i = 0; i < 4; i++, c >>= 8){
+					h ^= c & 0xff;
+					h *= 1099511628211ULL;
+				}
+			}
+		} else {
+			for(x = 0; x < s->w * bpp; x++){
+				h ^= row[x];
+				h *= 1099511628211ULL;
+			}
+		}
+	}
+	return h;
+}
+
+static void present_headless(){
+	char name[300];
+
+	if(!vram)
+		return;
+
+	if(SDL_MUSTLOCK(vram))
+		SDL_LockSurface(vram);
+	if(vflags & VIDEO_HASH)
+		frame_hash = hash_surface(vram);
+	if(SDL_MUSTLOCK(vram))
+		SDL_UnlockSurface(vram);
+
+	if(vflags & VIDEO_DUMP){
+		snprintf(name, sizeof(name), dump_pattern, (unsigned)frame_count);
+		if(SDL_SaveBMP(vram, name) < 0)
+			printf("error: %s\n", SDL_GetError());
+	}
+}
+
+/*
+  Escala vram a la ventana. Con regiones sucias solo se escalan y suben las
+  zonas modificadas; EPX lee los vecinos, así que cada zona crece un píxel.
+  */
+static void present_scaled(){
+	static SDL_Rect out[DIRTY_MAX_RECTS];
+	SDL_Rect *rects, r;
+	int count, i, x2, y2;
+
+	if(!dirty_rect_enabled()){
+		present_scale(vram, screen, NULL, vscale, vscale_flags);
+		SDL_Flip(screen);
+		return;
+	}
+
+	rects = dirty_rect_get(&count);
+	for(i = 0; i < count; i++){
+		r = rects[i];
+		if(vscale_flags & PRESENT_EPX){
+			x2 = r.x + r.w + 1 < vram->w ? r.x + r.w + 1 : vram->w;
+			y2 = r.y + r.h + 1 < vram->h ? r.y + r.h + 1 : vram->h;
+			r.x = r.x > 0 ? r.x - 1 : 0;
+			r.y = r.y > 0 ? r.y - 1 : 0;
+			r.w = x2 - r.x;
+			r.h = y2 - r.y;
+		}
+		present_scale(vram, screen, &r, vscale, vscale_flags);
+		out[i].x = r.x * vscale;
+		out[i].y = r.y * vscale;
+		out[i].w = r.w * vscale;
+		out[i].h = r.h * vscale;
+	}
+	if(count > 0)
+		SDL_UpdateRects(screen, count, out);
+	dirty_rect_clear();
+}
+
+void video_set_flags(int flags){
+	vflags = flags;
+}
+
+int video_flags(){
+	return vflags;
+}
+
+void video_set_dump_pattern(const char *pattern){
+	if(!pattern)
+		return;
+	strncpy(dump_pattern, pattern, sizeof(dump_pattern) - 1);
+	dump_pattern[sizeof(dump_pattern) - 1] = 0;
+}
+
+Uint64 video_frame_hash(){
+	return frame_hash;
+}
+
+Uint32 video_frame_count(){
+	return frame_count;
+}
+
+
+// copia vram a la pantalla (o al modo sin ventana) y limpia los rectángulos
+static void present_frame(){
+	SDL_Rect *rects;
+	int count;
+
+	if(vflags & VIDEO_HEADLESS){
+		present_headless();
+		dirty_rect_clear();
+		return;
+	}
+
+	if(screen){
+		present_scaled();
+		return;
+	}
+
+	if(!dirty_rect_enabled()){
+		SDL_Flip(vram);
+		return;
+	}
+
+	rects = dirty_rect_get(&count);
+	if(count > 0)
+		SDL_UpdateRects(vram, count, rects);
+	dirty_rect_clear();
+}
+
 /**
  * @brief Renderiza los gráficos en la pantalla.
  *
@@ -157,9 +390,29 @@ void off_video(){
  * @note Asegúrese de que todos los objetos gráficos y recursos hayan sido preparados
  *       antes de llamar a esta función. Esta función puede implicar una actualización
  *       de la superficie de video o del framebuffer.
+ *
+ * @note Con `dirty_rect_enable(1)` solo se presentan los rectángulos registrados
+ *       durante el frame mediante `SDL_UpdateRects`; si no hubo cambios no se
+ *       copia nada al framebuffer.
+ *
+ * @note También avanza las animaciones de los sprites que llamaron a
+ *       `animate()` en este frame, con `anim_update()`.
  */
 void Render(){
-	SDL_Flip(vram);
+	PERF_TIMER_BEGIN(PERF_PRESENT_NS);
+
+	// una sola muestra del reloj por frame para todas las animaciones
+	anim_update();
+	frame_count++;
+
+#if PERF_ENABLED
+	if(perf_hud_visible())
+		perf_draw_hud(4, 4);
+#endif
+
+	present_frame();
+	PERF_TIMER_END(PERF_PRESENT_NS);
+	PERF_FRAME();
 }
 
 /**
@@ -174,11 +427,9 @@ void Render(){
  *       o la superficie de video asociada.
  */
 void cls() {
-    int i;
-    // Limpia toda la superficie poniendo todos los píxeles a 0x00000000 (negro)
-    for (i = 0; i < vram->w * vram->h; i++) {
-        fb[i] = 0x00000000;  // Asigna el color negro (0x00000000) a cada píxel
-    }
+    // Limpia toda la superficie a negro respetando el pitch de cada fila
+    fill_surface(vram, 0x00000000);
+    dirty_rect_add_all();
 }
 
 /**
@@ -197,7 +448,8 @@ void cls() {
  *       desea borrar la pantalla con un color particular.
  */
 void cls_rgb(u8 r, u8 g, u8 b){
-	SDL_FillRect(vram,0,SDL_MapRGB(vram->format,r,g,b));
+	fill_surface(vram, pixfmt_pack(pixfmt_video(), r, g, b));
+	dirty_rect_add_all();
 }
 
 /**
@@ -214,25 +466,18 @@ void cls_rgb(u8 r, u8 g, u8 b){
  * @return El valor del color en formato ARGB (A=255, R=r, G=g, B=b).
  */
 u32 color_rgb(u8 r, u8 g, u8 b) {
-    return SDL_MapRGB(vram->format,r,g,b);
+    return pixfmt_pack(pixfmt_video(), r, g, b);
 }
 
 void Fps_sincronizar(int frecuencia)
 {
-	static int t;
-	static int temp;
-	static int t1 = 0;
-
-	t = SDL_GetTicks();
-	if (t - t1 >= frecuencia)
-	{
-		temp = (t - t1) / frecuencia;
-		t1 += temp * frecuencia;
-	}
-	else
-	{
-		SDL_Delay(frecuencia - (t - t1));
-		t1 += frecuencia;
+	static int actual = -1;
+
+	// el periodo solo se reprograma si cambia, para no perder la fase
+	if (frecuencia != actual) {
+		pacer_set_period_ns((Uint64)frecuencia * 1000000);
+		actual = frecuencia;
 	}
+	pacer_wait();
 }
 